@@ -0,0 +1,122 @@
+#ifndef SCPICOMMAND_H
+#define SCPICOMMAND_H
+
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+
+/**
+  * Capacity of a SCPICommand. Longer commands are marked as overflowed and are
+  * not sent.
+  */
+#define SCPI_COMMAND_SIZE 64
+
+/**
+  * @brief A SCPI command formatted in a stack buffer.
+  *
+  * Built by SCPICommandTemplate without any allocation. The bytes are not NUL
+  * terminated; send them with GPIBPort::write(const SCPICommand &) or SCPIDevice::write.
+  * Plain C++17, it does not depend on Qt.
+  */
+class SCPICommand
+{
+public:
+    SCPICommand()
+    {
+        length = 0;
+        overflowed = false;
+    }
+
+    /**
+      * @brief Append raw bytes, truncated to the capacity of the command.
+      */
+    void append(const char *text, int count)
+    {
+        if( count > SCPI_COMMAND_SIZE - length ){
+            count = SCPI_COMMAND_SIZE - length;
+            overflowed = true;
+        }
+        memcpy( data + length, text, count );
+        length += count;
+    }
+
+    void append(int value)
+    {
+        std::to_chars_result result = std::to_chars( data + length, data + SCPI_COMMAND_SIZE, value );
+        if( result.ec == std::errc() ) length = (int)( result.ptr - data );
+        else overflowed = true;
+    }
+
+    /**
+      * @brief Append a number with 6 significant digits, as QString::arg(double).
+      */
+    void append(double value)
+    {
+        std::to_chars_result result = std::to_chars( data + length, data + SCPI_COMMAND_SIZE, value, std::chars_format::general, 6 );
+        if( result.ec == std::errc() ) length = (int)( result.ptr - data );
+        else overflowed = true;
+    }
+
+    void append(bool state)
+    {
+        if( state ) append( "ON", 2 );
+        else append( "OFF", 3 );
+    }
+
+    const char *constData() const {return data;}
+    int size() const {return length;}
+    std::string_view view() const {return std::string_view( data, length );}
+
+    /**
+      * @brief True if something did not fit in the command, so the bytes are not the whole of it.
+      */
+    bool isOverflowed() const {return overflowed;}
+
+private:
+    char data[SCPI_COMMAND_SIZE];
+    int  length;
+    bool overflowed;
+};
+
+/**
+  * @brief Compile time description of a SCPI command: a fixed header and typed parameters.
+  *
+  * The header bytes and their length are known at compile time, the parameters are
+  * formatted with std::to_chars as QString::arg would (%g for doubles, ON/OFF for
+  * bools) and separated with commas. The header of a command with parameters ends
+  * with the space before them.
+  *
+  *     constexpr SCPICommandTemplate<double> LEVEL( ":SOUR:VOLT:LEV " );
+  *     port->write( LEVEL( 1.5 ) );
+  */
+template <typename... Parameters>
+class SCPICommandTemplate
+{
+public:
+    template <std::size_t N>
+    constexpr SCPICommandTemplate(const char (&text)[N]) : header(text), headerLength((int)N - 1) {}
+
+    SCPICommand operator()(Parameters... values) const
+    {
+        SCPICommand command;
+        command.append( header, headerLength );
+        int index = 0;
+        (void)index;
+        ( appendParameter( command, values, index++ ), ... );
+        return command;
+    }
+
+private:
+    template <typename T>
+    static void appendParameter(SCPICommand &command, T value, int index)
+    {
+        if( index > 0 ) command.append( ",", 1 );
+        command.append( value );
+    }
+
+    const char *header;
+    int         headerLength;
+};
+
+#endif // SCPICOMMAND_H
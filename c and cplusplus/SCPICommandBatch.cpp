@@ -0,0 +1,102 @@
+#include "../GPIB/SCPICommandBatch.h"
+
+/**
+  * @brief Constructor
+  *
+  * @param maxMessageSize Maximum number of bytes of every program message.
+  */
+SCPICommandBatch::SCPICommandBatch(int maxMessageSize)
+{
+    maxSize = maxMessageSize;
+}
+
+SCPICommandBatch::~SCPICommandBatch()
+{
+}
+
+/**
+  * @brief Add a command to the batch.
+  *
+  * @param command A QString as returned by SCPICommandFactory.
+  */
+void SCPICommandBatch::append(const QString &command)
+{
+    QString unit = command.trimmed();
+    if( !unit.isEmpty() ) commands.append(unit);
+}
+
+SCPICommandBatch &SCPICommandBatch::operator<<(const QString &command)
+{
+    append(command);
+    return *this;
+}
+
+/**
+  * @brief Build the program messages that flush would send.
+  *
+  * Commands are joined with ";". A leading ":" is added to headers that do not have
+  * one, so every command is parsed from the root of the command tree. A new program
+  * message is started when the current one would exceed the maximum size.
+  *
+  * @param cache If given, the commands that it reports as redundant are left out.
+  */
+QList<QByteArray> SCPICommandBatch::programMessages(const SCPIStateCache *cache) const
+{
+    QList<QByteArray> messages;
+
+    // Follow the settings made by the batch itself
+    SCPIStateCache shadow;
+    if( cache != 0 ) shadow = *cache;
+
+    for( int i = 0; i < commands.size(); i++ ){
+        if( cache != 0 ){
+            if( shadow.isRedundant(commands.at(i)) ) continue;
+            shadow.update(commands.at(i));
+        }
+
+        QByteArray unit = commands.at(i).toLatin1();
+        if( !unit.startsWith(':') && !unit.startsWith('*') ) unit.prepend(':');
+
+        if( messages.isEmpty() || messages.last().size() + 1 + unit.size() > maxSize ){
+            messages.append(unit);
+        } else {
+            messages.last().append(';');
+            messages.last().append(unit);
+        }
+    }
+    return messages;
+}
+
+/**
+  * @brief Send the batched commands and empty the batch.
+  *
+  * The bus is held for the whole batch. Sending stops at the first error.
+  *
+  * @param port The GPIBPort of the instrument.
+  */
+int SCPICommandBatch::flush(GPIBPort *port)
+{
+    int status = EXIT_SUCCESS;
+    GPIBBusLock bus( BOARD_INDEX, port->getAddress(), port->getBusPriority() );
+
+    SCPIStateCache *cache = port->getStateCache();
+    QList<QByteArray> messages = programMessages( port->isStateCacheEnabled() ? cache : 0 );
+
+    for( int i = 0; i < messages.size() && status == EXIT_SUCCESS; i++ ){
+        if( !port->isNoError() ) return -1;
+        // The port updates the cache with what it sends
+        status = port->write( messages.at(i).constData(), messages.at(i).size() );
+    }
+
+    clear();
+    return status;
+}
+
+void SCPICommandBatch::clear()
+{
+    commands.clear();
+}
+
+int SCPICommandBatch::count() const {return commands.size();}
+
+bool SCPICommandBatch::isEmpty() const {return commands.isEmpty();}
@@ -0,0 +1,47 @@
+#ifndef SCPICOMMANDBATCH_H
+#define SCPICOMMANDBATCH_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include "./gpib/parallelCommunications/gpib/gpibPort.h"
+
+/**
+  * Maximum length of a program message built by SCPICommandBatch.
+  * Keep it below the input buffer of the instrument.
+  */
+#define SCPI_INPUT_BUFFER_SIZE 1024
+
+/**
+  * @brief Collects the commands built by SCPICommandFactory and sends them as
+  * ";"-joined program messages.
+  *
+  * A typical configuration is sent with one or two ibwrt instead of one per
+  * command. Only commands should be batched: responses of queries would be
+  * queued together in the instrument output. When the port has its state cache
+  * enabled, the settings already in the instrument are left out.
+  */
+class SCPICommandBatch
+{
+public:
+    SCPICommandBatch(int maxMessageSize = SCPI_INPUT_BUFFER_SIZE);
+    ~SCPICommandBatch();
+
+    void append(const QString &command);
+    SCPICommandBatch &operator<<(const QString &command);
+
+    QList<QByteArray> programMessages(const SCPIStateCache *cache = 0) const;
+    int  flush(GPIBPort *port);
+    void clear();
+
+    int  count() const;
+    bool isEmpty() const;
+
+private:
+    int maxSize;
+    QStringList commands;
+};
+
+#endif // SCPICOMMANDBATCH_H
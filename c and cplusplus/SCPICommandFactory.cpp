@@ -2,6 +2,14 @@
 
 #include "./Instruments/keithley/sourceMeters/K24xxConfigurationParameters.h"
 
+/**
+  * @brief A command built by a SCPICommandTemplate as a QString.
+  */
+static QString text(const SCPICommand &command)
+{
+    return QString::fromLatin1( command.constData(), command.size() );
+}
+
 /**
   * @brief Constructor
   */
@@ -72,7 +80,7 @@ QString SCPICommandFactory::clearTriggerCountBuffer()
  */
 
 QString SCPICommandFactory::setBufferOfReadingsSize(int _size){
-    QString output = QString(":TRAC:POIN %1").arg( _size );
+    QString output = text( BUFFER_SIZE( _size ) );
 
     return output;
 }
@@ -189,7 +197,7 @@ QString SCPICommandFactory::setInCurrentMeasureMode()
  */
 QString SCPICommandFactory::setVoltageSourceRange(double voltageSourceRange)
 {
-    QString output = QString(":SOUR:VOLT:RANG %1").arg(voltageSourceRange);
+    QString output = text( VOLTAGE_SOURCE_RANGE( voltageSourceRange ) );
 
     return output;
 }
@@ -201,7 +209,7 @@ QString SCPICommandFactory::setVoltageSourceRange(double voltageSourceRange)
  */
 QString SCPICommandFactory::setCurrentSourceRange(double currentSourceRange)
 {
-    QString output = QString(":SOUR:CURR:RANG %1").arg(currentSourceRange);
+    QString output = text( CURRENT_SOURCE_RANGE( currentSourceRange ) );
 
     return output;
 }
@@ -225,12 +233,7 @@ QString SCPICommandFactory::setCurrentSourceRangeToMin()
  */
 QString SCPICommandFactory::concurrentMeasure( bool status )
 {
-    QString output;
-    if( status )
-        output = ":SENS:FUNC:CONC ON";
-    else
-        output = ":SENS:FUNC:CONC OFF";
-
+    QString output = text( CONCURRENT_MEASURE( status ) );
 
     return output;
 }
@@ -243,7 +246,7 @@ QString SCPICommandFactory::concurrentMeasure( bool status )
 
 QString SCPICommandFactory::setCurrentCompliance(double currentCompliance)
 {
-    QString output = QString(":SENS:CURR:PROT %1").arg( currentCompliance );
+    QString output = text( CURRENT_COMPLIANCE( currentCompliance ) );
 
     return output;
 }
@@ -256,7 +259,7 @@ QString SCPICommandFactory::setCurrentCompliance(double currentCompliance)
 
 QString SCPICommandFactory::setVoltageCompliance(double voltageCompliance)
 {
-    QString output = QString(":SENS:VOLT:PROT %1").arg( voltageCompliance );
+    QString output = text( VOLTAGE_COMPLIANCE( voltageCompliance ) );
 
     return output;
 }
@@ -286,12 +289,7 @@ QString SCPICommandFactory::setNplc(QString nplc)
 
 QString SCPICommandFactory::setVoltageMeasureRangeInAuto(bool status)
 {
-    QString output;
-    if( status )
-        output = ":SENS:VOLT:RANG:AUTO ON";
-    else
-        output = ":SENS:VOLT:RANG:AUTO OFF";
-
+    QString output = text( VOLTAGE_MEASURE_RANGE_AUTO( status ) );
 
     return output;
 }
@@ -304,7 +302,7 @@ QString SCPICommandFactory::setVoltageMeasureRangeInAuto(bool status)
 
 QString SCPICommandFactory::setVoltageMeasureRange(double measureRange)
 {
-    QString output = QString(":SENS:VOLT:RANG %1").arg( measureRange );
+    QString output = text( VOLTAGE_MEASURE_RANGE( measureRange ) );
 
     return output;
 }
@@ -317,12 +315,7 @@ QString SCPICommandFactory::setVoltageMeasureRange(double measureRange)
 
 QString SCPICommandFactory::setCurrentMeasureRangeInAuto(bool status)
 {
-    QString output;
-    if( status )
-        output = ":SENS:CURR:RANG:AUTO ON";
-    else
-        output = ":SENS:CURR:RANG:AUTO OFF";
-
+    QString output = text( CURRENT_MEASURE_RANGE_AUTO( status ) );
 
     return output;
 }
@@ -335,7 +328,7 @@ QString SCPICommandFactory::setCurrentMeasureRangeInAuto(bool status)
 
 QString SCPICommandFactory::setCurrentMeasureRange(double measureRange)
 {
-    QString output = QString(":SENS:CURR:RANG %1").arg( measureRange );
+    QString output = text( CURRENT_MEASURE_RANGE( measureRange ) );
 
     return output;
 }
@@ -347,12 +340,7 @@ QString SCPICommandFactory::setCurrentMeasureRange(double measureRange)
   */
 QString SCPICommandFactory::enableFilter(bool status)
 {
-    QString output;
-    if( status )
-        output = ":SENS:AVER:STAT ON";
-    else
-        output = ":SENS:AVER:STAT OFF";
-
+    QString output = text( FILTER_STATE( status ) );
 
     return output;
 }
@@ -366,7 +354,7 @@ QString SCPICommandFactory::enableFilter(bool status)
 QString SCPICommandFactory::setFilterCount(int filterCount)
 {
     QString output;
-    output = QString(":SENS:AVER:COUN %1").arg( filterCount ) ;
+    output = text( FILTER_COUNT( filterCount ) );
 
     return output;
 }
@@ -411,7 +399,7 @@ QString SCPICommandFactory::setFilterType(int filterTypeIndex)
 QString SCPICommandFactory::setVoltageSourceLevel(double sourceLevel)
 {
     QString output;
-    output = QString( ":SOUR:VOLT:LEV %1" ).arg( sourceLevel ) ;
+    output = text( VOLTAGE_SOURCE_LEVEL( sourceLevel ) );
 
     return output;
 }
@@ -425,7 +413,7 @@ QString SCPICommandFactory::setVoltageSourceLevel(double sourceLevel)
 QString SCPICommandFactory::setCurrentSourceLevel(double sourceLevel)
 {
     QString output;
-    output = QString( ":SOUR:CURR:LEV %1" ).arg( sourceLevel ) ;
+    output = text( CURRENT_SOURCE_LEVEL( sourceLevel ) );
 
     return output;
 }
@@ -439,7 +427,7 @@ QString SCPICommandFactory::setCurrentSourceLevel(double sourceLevel)
 QString SCPICommandFactory::setPulseWidth(double width)
 {
     QString output;
-    output = QString( ":SOUR:PULS:WIDT %1" ).arg( width ) ;
+    output = text( PULSE_WIDTH( width ) );
 
     return output;
 }
@@ -453,7 +441,7 @@ QString SCPICommandFactory::setPulseWidth(double width)
 QString SCPICommandFactory::setPulseDelay( double pulseDelay )
 {
     QString output;
-    output = QString( ":SOUR:PULS:DEL %1" ).arg( pulseDelay ) ;
+    output = text( PULSE_DELAY( pulseDelay ) );
 
     return output;
 }
@@ -466,12 +454,7 @@ QString SCPICommandFactory::setPulseDelay( double pulseDelay )
 
 QString SCPICommandFactory::enableOutput(bool status)
 {
-    QString output;
-    if( status )
-        output = ":OUTP:STAT ON";
-    else
-        output = ":OUTP:STAT OFF";
-
+    QString output = text( OUTPUT_STATE( status ) );
 
     return output;
 }
@@ -617,7 +600,7 @@ QString SCPICommandFactory::setTriggerCount( int triggerCount )
     if( triggerCount > 2500 || triggerCount < 1)
         triggerCount = 2500;
 
-    output = QString( ":TRIG:COUN %1" ).arg( triggerCount ) ;
+    output = text( TRIGGER_COUNT( triggerCount ) );
 
     return output;
 }
@@ -631,7 +614,7 @@ QString SCPICommandFactory::setVoltageSweepStart(const double sweepVoltageStart)
 {
     QString output;
 
-    output = QString( ":SOUR:VOLT:STAR %1" ).arg( sweepVoltageStart ) ;
+    output = text( VOLTAGE_SWEEP_START( sweepVoltageStart ) );
 
     return output;
 }
@@ -645,7 +628,7 @@ QString SCPICommandFactory::setVoltageSweepStop(const double sweepVoltageStop)
 {
     QString output;
 
-    output = QString( ":SOUR:VOLT:STOP %1" ).arg( sweepVoltageStop ) ;
+    output = text( VOLTAGE_SWEEP_STOP( sweepVoltageStop ) );
 
     return output;
 }
@@ -659,7 +642,7 @@ QString SCPICommandFactory::setCurrentSweepStart(const double sweepCurrentStart)
 {
     QString output;
 
-    output = QString( ":SOUR:CURR:STAR %1" ).arg( sweepCurrentStart ) ;
+    output = text( CURRENT_SWEEP_START( sweepCurrentStart ) );
 
     return output;
 }
@@ -673,7 +656,7 @@ QString SCPICommandFactory::setCurrentSweepStop(const double sweepCurrentStop)
 {
     QString output;
 
-    output = QString( ":SOUR:CURR:STOP %1" ).arg( sweepCurrentStop );
+    output = text( CURRENT_SWEEP_STOP( sweepCurrentStop ) );
 
     return output;
 }
@@ -687,7 +670,7 @@ QString SCPICommandFactory::setVoltageSweepStep(const double sweepVoltageStep)
 {
     QString output;
 
-    output = QString( ":SOUR:VOLT:STEP %1" ).arg( sweepVoltageStep );
+    output = text( VOLTAGE_SWEEP_STEP( sweepVoltageStep ) );
 
     return output;
 }
@@ -701,7 +684,7 @@ QString SCPICommandFactory::setCurrentSweepStep(const double sweepCurrentStep)
 {
     QString output;
 
-    output = QString( ":SOUR:CURR:STEP %1" ).arg( sweepCurrentStep );
+    output = text( CURRENT_SWEEP_STEP( sweepCurrentStep ) );
 
     return output;
 }
@@ -758,7 +741,7 @@ QString SCPICommandFactory::setSweepPoints(const int sweepPoints)
 {
     QString output;
 
-    output = QString( ":SOUR:SWE:POIN %1" ).arg( sweepPoints );
+    output = text( SWEEP_POINTS( sweepPoints ) );
 
     return output;
 }
@@ -775,6 +758,18 @@ QString SCPICommandFactory::clearStatus()
     return output;
 }
 
+/**
+ * @brief Operation Complete. Sets the OPC bit of the Standard Event register when
+ * all the pending operations (e.g. a triggered sweep) have finished.
+ */
+
+QString SCPICommandFactory::operationComplete()
+{
+    QString output = "*OPC";
+
+    return output;
+}
+
 /**
  * @brief Program Service Request enable register
  *
@@ -783,7 +778,7 @@ QString SCPICommandFactory::clearStatus()
 
 QString SCPICommandFactory::programSrqr(const int config)
 {
-    QString output = QString("*SRE %1").arg(config);
+    QString output = text( SERVICE_REQUEST_ENABLE( config ) );
 
     return output;
 }
@@ -796,7 +791,7 @@ QString SCPICommandFactory::programSrqr(const int config)
 
 QString SCPICommandFactory::programSer(const int config)
 {
-    QString output = QString("*ESE %1").arg(config);
+    QString output = text( EVENT_STATUS_ENABLE( config ) );
 
     return output;
 }
@@ -809,7 +804,7 @@ QString SCPICommandFactory::programSer(const int config)
 
 QString SCPICommandFactory::programOer(const int config)
 {
-    QString output = QString(":STAT:OPER:ENAB %1").arg(config);
+    QString output = text( OPERATION_ENABLE( config ) );
 
     return output;
 }
@@ -822,7 +817,7 @@ QString SCPICommandFactory::programOer(const int config)
 
 QString SCPICommandFactory::programMer(const int config)
 {
-    QString output = QString(":STAT:MEAS:ENAB %1").arg(config);
+    QString output = text( MEASUREMENT_ENABLE( config ) );
 
     return output;
 }
@@ -835,7 +830,7 @@ QString SCPICommandFactory::programMer(const int config)
 
 QString SCPICommandFactory::programQer(const int config)
 {
-    QString output = QString(":STAT:QUES:ENAB %1").arg(config);
+    QString output = text( QUESTIONABLE_ENABLE( config ) );
 
     return output;
 }
@@ -871,6 +866,62 @@ QString SCPICommandFactory::formatStatusRegister(const int format)
     return output;
 }
 
+/**
+ * @brief Select the data format used to send readings over the bus
+ *
+ * @param format An int used as an index to choose between formats: DATA_FORMAT_ASCII,
+ * DATA_FORMAT_REAL32, DATA_FORMAT_REAL64. REAL formats send readings as an IEEE 488.2 binary block.
+ */
+
+QString SCPICommandFactory::formatData(const int format)
+{
+    QString output;
+    switch ( format ) {
+    case DATA_FORMAT_REAL32:
+        output = QString(":FORM:DATA REAL,32");
+        break;
+    case DATA_FORMAT_REAL64:
+        output = QString(":FORM:DATA REAL,64");
+        break;
+    default:
+        output = QString(":FORM:DATA ASC");
+        break;
+    }
+
+    return output;
+}
+
+/**
+ * @brief Select the byte order of binary readings
+ *
+ * @param swapped A bool to send the least significant byte first (SWAPped) instead of NORMal.
+ */
+
+QString SCPICommandFactory::formatByteOrder(const bool swapped)
+{
+    QString output;
+    if(swapped)
+        output = QString(":FORM:BORD SWAP");
+    else
+        output = QString(":FORM:BORD NORM");
+
+    return output;
+}
+
+/**
+ * @brief Select the elements sent for every reading
+ *
+ * @param elements A QString with the elements to send, e.g. "VOLT,CURR,TIME". The instrument
+ * always sends them in the order VOLT, CURR, RES, TIME, STAT.
+ */
+
+QString SCPICommandFactory::formatElements(const QString elements)
+{
+    QString output = QString( ":FORM:ELEM " + elements );
+
+    return output;
+}
+
 /**
  * @brief Select terminals connections rear or front
  *
@@ -5,10 +5,54 @@
 #include <QVariant>
 #include <QObject>
 
+#include "../GPIB/ieee4882Block.h"
+#include "../GPIB/SCPICommand.h"
+
+/**
+  * @brief Builds the SCPI commands of the Keithley 24xx.
+  *
+  * The commands with parameters are described by the SCPICommandTemplate constants,
+  * which format them in a stack buffer. The QString methods are wrappers for the
+  * code that works with QString; use the constants directly where the command is
+  * built in a loop:
+  *
+  *     port->write( SCPICommandFactory::VOLTAGE_SOURCE_LEVEL( level ) );
+  */
 class SCPICommandFactory : public QObject
 {
     Q_OBJECT
 public:
+    static constexpr SCPICommandTemplate<int>    BUFFER_SIZE { ":TRAC:POIN " };
+    static constexpr SCPICommandTemplate<double> VOLTAGE_SOURCE_RANGE { ":SOUR:VOLT:RANG " };
+    static constexpr SCPICommandTemplate<double> CURRENT_SOURCE_RANGE { ":SOUR:CURR:RANG " };
+    static constexpr SCPICommandTemplate<bool>   CONCURRENT_MEASURE { ":SENS:FUNC:CONC " };
+    static constexpr SCPICommandTemplate<double> CURRENT_COMPLIANCE { ":SENS:CURR:PROT " };
+    static constexpr SCPICommandTemplate<double> VOLTAGE_COMPLIANCE { ":SENS:VOLT:PROT " };
+    static constexpr SCPICommandTemplate<bool>   VOLTAGE_MEASURE_RANGE_AUTO { ":SENS:VOLT:RANG:AUTO " };
+    static constexpr SCPICommandTemplate<double> VOLTAGE_MEASURE_RANGE { ":SENS:VOLT:RANG " };
+    static constexpr SCPICommandTemplate<bool>   CURRENT_MEASURE_RANGE_AUTO { ":SENS:CURR:RANG:AUTO " };
+    static constexpr SCPICommandTemplate<double> CURRENT_MEASURE_RANGE { ":SENS:CURR:RANG " };
+    static constexpr SCPICommandTemplate<bool>   FILTER_STATE { ":SENS:AVER:STAT " };
+    static constexpr SCPICommandTemplate<int>    FILTER_COUNT { ":SENS:AVER:COUN " };
+    static constexpr SCPICommandTemplate<double> VOLTAGE_SOURCE_LEVEL { ":SOUR:VOLT:LEV " };
+    static constexpr SCPICommandTemplate<double> CURRENT_SOURCE_LEVEL { ":SOUR:CURR:LEV " };
+    static constexpr SCPICommandTemplate<double> PULSE_WIDTH { ":SOUR:PULS:WIDT " };
+    static constexpr SCPICommandTemplate<double> PULSE_DELAY { ":SOUR:PULS:DEL " };
+    static constexpr SCPICommandTemplate<bool>   OUTPUT_STATE { ":OUTP:STAT " };
+    static constexpr SCPICommandTemplate<int>    TRIGGER_COUNT { ":TRIG:COUN " };
+    static constexpr SCPICommandTemplate<double> VOLTAGE_SWEEP_START { ":SOUR:VOLT:STAR " };
+    static constexpr SCPICommandTemplate<double> VOLTAGE_SWEEP_STOP { ":SOUR:VOLT:STOP " };
+    static constexpr SCPICommandTemplate<double> VOLTAGE_SWEEP_STEP { ":SOUR:VOLT:STEP " };
+    static constexpr SCPICommandTemplate<double> CURRENT_SWEEP_START { ":SOUR:CURR:STAR " };
+    static constexpr SCPICommandTemplate<double> CURRENT_SWEEP_STOP { ":SOUR:CURR:STOP " };
+    static constexpr SCPICommandTemplate<double> CURRENT_SWEEP_STEP { ":SOUR:CURR:STEP " };
+    static constexpr SCPICommandTemplate<int>    SWEEP_POINTS { ":SOUR:SWE:POIN " };
+    static constexpr SCPICommandTemplate<int>    SERVICE_REQUEST_ENABLE { "*SRE " };
+    static constexpr SCPICommandTemplate<int>    EVENT_STATUS_ENABLE { "*ESE " };
+    static constexpr SCPICommandTemplate<int>    OPERATION_ENABLE { ":STAT:OPER:ENAB " };
+    static constexpr SCPICommandTemplate<int>    MEASUREMENT_ENABLE { ":STAT:MEAS:ENAB " };
+    static constexpr SCPICommandTemplate<int>    QUESTIONABLE_ENABLE { ":STAT:QUES:ENAB " };
+
     SCPICommandFactory();
     ~SCPICommandFactory();
 
@@ -92,6 +136,7 @@ public:
     QString setSweepPoints( const int sweepPoints );
 
     QString clearStatus();
+    QString operationComplete();
 
     QString programSrqr(const int config);
     QString programSer(const int config);
@@ -100,6 +145,9 @@ public:
     QString programQer(const int config);
 
     QString formatStatusRegister(const int format);
+    QString formatData(const int format);
+    QString formatByteOrder(const bool swapped);
+    QString formatElements(const QString elements);
 
     QString terminalsRoute( const bool state );
 
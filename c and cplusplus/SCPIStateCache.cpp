@@ -0,0 +1,145 @@
+#include "../GPIB/SCPIStateCache.h"
+
+/**
+  * Commands after which the instrument settings are unknown
+  */
+static const char *const resetHeaders[] = { "*RST", "*RCL", "SYST:PRES", "SYSTEM:PRESET" };
+
+/**
+  * Commands with parameters that must always be sent
+  *  - TRAC:FEED:CONT goes back to NEV when the buffer of readings is full
+  *  - OUTP:STAT goes OFF after every reading with :SOUR:CLE:AUTO ON
+  *  - *SAV stores the current settings, so it is not a setting itself
+  */
+static const char *const volatileHeaders[] = { "TRAC:FEED:CONT", "OUTP", "OUTP:STAT", "*SAV" };
+
+/**
+  * @brief Constructor
+  */
+SCPIStateCache::SCPIStateCache()
+{
+}
+
+SCPIStateCache::~SCPIStateCache()
+{
+}
+
+/**
+  * @brief Check if a command would leave the instrument as it is.
+  *
+  * @param command A single SCPI command, as returned by SCPICommandFactory.
+  * @return true if the same value was the last one sent for this header.
+  */
+bool SCPIStateCache::isRedundant(const QString &command) const
+{
+    QString header, value;
+    if( command.contains(';') ) return false;
+    if( !split(command, header, value) ) return false;
+    if( isReset(header) || isVolatile(header) ) return false;
+
+    return state.contains(header) && state.value(header) == value;
+}
+
+/**
+  * @brief Record a command that has been sent to the instrument.
+  *
+  * @param command One or several ";"-joined SCPI commands.
+  */
+void SCPIStateCache::update(const QString &command)
+{
+    QStringList units = command.split(';');
+    for( int i = 0; i < units.size(); i++ ){
+        QString header, value;
+        bool setting = split(units.at(i), header, value);
+        // Checked first: *RCL takes a parameter but is not a setting
+        if( isReset(header) ){
+            invalidate();
+        } else if( setting && !isVolatile(header) ){
+            state.insert(header, value);
+        }
+    }
+}
+
+/**
+  * @brief Forget the settings of a command that may or may not have reached the
+  * instrument, e.g. an asynchronous write.
+  *
+  * @param command One or several ";"-joined SCPI commands.
+  */
+void SCPIStateCache::forget(const QString &command)
+{
+    QStringList units = command.split(';');
+    for( int i = 0; i < units.size(); i++ ){
+        QString header, value;
+        split(units.at(i), header, value);
+        if( isReset(header) ) invalidate();
+        else state.remove(header);
+    }
+}
+
+/**
+  * @brief Forget every setting, after a reset, a device clear or an error.
+  */
+void SCPIStateCache::invalidate()
+{
+    state.clear();
+}
+
+bool SCPIStateCache::contains(const QString &header) const
+{
+    return state.contains(header);
+}
+
+/**
+  * @brief Last value sent for a header.
+  *
+  * @param header Header without the leading ":", in upper case. E.g. "SENS:VOLT:NPLC".
+  */
+QString SCPIStateCache::value(const QString &header) const
+{
+    return state.value(header);
+}
+
+/**
+  * @brief Split a command in header and parameters.
+  *
+  * The header is returned without the leading ":" and in upper case.
+  *
+  * @return true if the command is a setting with parameters that can be cached.
+  */
+bool SCPIStateCache::split(const QString &command, QString &header, QString &value)
+{
+    QString unit = command.trimmed();
+    if( unit.startsWith(':') ) unit = unit.mid(1);
+
+    int space = unit.indexOf(' ');
+    if( space < 0 ){
+        header = unit.toUpper();
+        value.clear();
+        return false;
+    }
+
+    header = unit.left(space).toUpper();
+    value = unit.mid(space + 1).trimmed();
+    return !header.endsWith('?') && !value.isEmpty();
+}
+
+/**
+  * @brief Check if a header resets the instrument settings (*RST, *RCL, :SYST:PRES).
+  */
+bool SCPIStateCache::isReset(const QString &header)
+{
+    for( unsigned int i = 0; i < sizeof(resetHeaders) / sizeof(resetHeaders[0]); i++ )
+        if( header == resetHeaders[i] ) return true;
+    return false;
+}
+
+/**
+  * @brief Check if a header must always be sent: a setting the instrument changes by itself, or *SAV.
+  */
+bool SCPIStateCache::isVolatile(const QString &header)
+{
+    for( unsigned int i = 0; i < sizeof(volatileHeaders) / sizeof(volatileHeaders[0]); i++ )
+        if( header == volatileHeaders[i] ) return true;
+    return false;
+}
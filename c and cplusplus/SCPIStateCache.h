@@ -0,0 +1,40 @@
+#ifndef SCPISTATECACHE_H
+#define SCPISTATECACHE_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+/**
+  * @brief Shadow copy of the instrument settings, keyed by SCPI header.
+  *
+  * Remembers the last value sent for every setting command so that a command that
+  * would not change the instrument state can be skipped. Queries and commands
+  * without parameters (:INIT, :TRAC:CLE, ...) are never considered redundant.
+  * *RST, *RCL and :SYST:PRES clear the cache, as the instrument state is unknown after them;
+  * they are never cached themselves. Settings the instrument changes by itself
+  * (e.g. :TRAC:FEED:CONT) and *SAV are never cached either.
+  */
+class SCPIStateCache
+{
+public:
+    SCPIStateCache();
+    ~SCPIStateCache();
+
+    bool isRedundant(const QString &command) const;
+    void update(const QString &command);
+    void forget(const QString &command);
+    void invalidate();
+
+    bool contains(const QString &header) const;
+    QString value(const QString &header) const;
+
+private:
+    static bool split(const QString &command, QString &header, QString &value);
+    static bool isReset(const QString &header);
+    static bool isVolatile(const QString &header);
+
+    QHash<QString, QString> state;
+};
+
+#endif // SCPISTATECACHE_H
@@ -3,10 +3,35 @@
 
 #include "iostream"
 
+#ifndef TEST
 inline int __stdcall cb(int ud, int LocalIbsta, int LocalIberr, long LocalIbcntl,void *RefData)
 {
     std::cout<<"Sfdsfdfdsds";
     return 0;
 }
+#endif
+
+/**
+  * @brief Interface for objects that receive ibnotify events.
+  *
+  * gpibNotify returns the new ibnotify mask, 0 to stop the notifications.
+  */
+class GpibNotifyReceiver
+{
+public:
+    virtual ~GpibNotifyReceiver(){}
+    virtual int gpibNotify(int ud, int LocalIbsta, int LocalIberr, long LocalIbcntl) = 0;
+};
+
+#ifndef TEST
+/**
+  * @brief ibnotify callback that forwards the event to the GpibNotifyReceiver passed as RefData.
+  */
+inline int __stdcall notifyReceiverCallback(int ud, int LocalIbsta, int LocalIberr, long LocalIbcntl, void *RefData)
+{
+    GpibNotifyReceiver *receiver = static_cast<GpibNotifyReceiver *>(RefData);
+    return receiver->gpibNotify(ud, LocalIbsta, LocalIberr, LocalIbcntl);
+}
+#endif
 
 #endif // CALLBACKFUNCTIONS_H
@@ -16,32 +16,39 @@
 #include "../GPIB/gpib.h"
 
 /**
-  * @brief Read messages from GPIB bus.
-  *
-  * @return A char[100] that contains 42 bytes read from the device.
+  * @brief Constructor
   */
+Gpib::Gpib(QObject *parent):QObject(parent)
+{
+    device = -1;
+    address = 0;
+    noError = true;
+    driver = GPIBDriver::defaultDriver();
+}
 
-static bool noError = true;
-static int device;
-
-
+Gpib::~Gpib()
+{
+    if( device >= 0 ) GPIBDescriptorPool::instance()->release( driver, device );
+}
 
+/**
+  * @brief Read messages from GPIB bus.
+  *
+  * @return A QVariant with the bytes read from the device (up to size), without the terminator.
+  */
 
 QVariant Gpib::read(const int size)
 {
-#ifndef TEST
-    char measure[size + 50];
+    QMutexLocker locker(&mutex);
+    QByteArray measure( size, '\0' );
+    long length = 0;
     if( noError ){
-        read( measure, size);
-        errors();
+        read( measure.data(), size );
+        if( noError ) length = stripTerminator( measure.constData(), lastStatus.ibcnt );
     }
+    measure.truncate( length );
 
     return QVariant(measure);
-#else
-    return QVariant("+9.979305E-01,+1.003080E-04,+1.074219E-02\n");
-    //return QVariant("UM, RANGE=12.000kV, VALUE=1.053kV");
-    //return QVariant("+5.000000E+00,+8.249011E-05,+5.285156E+02,+6.111000E+00,+8.381449E-05,+5.285205E+02,+7.222000E+00,+8.429056E-05,+5.285254E+02,+8.333500E+00,+8.415909E-05,+5.285303E+02,+9.444500E+00,+8.352670E-05,+5.285352E+02,+1.055550E+01,+8.389394E-05,+5.285400E+02,+1.166650E+01,+8.381329E-05,+5.285449E+02,+1.277800E+01,+8.840705E-05,+5.285498E+02,+1.388900E+01,+8.393636E-05,+5.285547E+02,+1.500000E+01,+8.438555E-05,+5.285596E+02\n\320\231\210\001\210a"" @0x1528be8");
-#endif
 
 }
 
@@ -53,12 +60,42 @@ QVariant Gpib::read(const int size)
   * @param size An integer that specifies the maximum number of bytes to read.
   */
 void Gpib::read(char * message, int size){
-#ifndef TEST
+    QMutexLocker locker(&mutex);
+    GPIBBusLock bus( BOARD_INDEX, address, BUS_PRIORITY_NORMAL );
     if( noError ){
-        ibrd (device, message, size);
+        int count = 0;
+        core.read( message, size, count );
+        lastStatus = core.status();
+        GPIBTrace::transfer( address, GPIB_TRACE_READ, lastStatus.ibsta, message, lastStatus.ibcnt );
         errors();
     }
-#endif
+}
+
+/**
+  * @brief Read an IEEE 488.2 binary block sent after :FORM:DATA REAL,32 or REAL,64.
+  *
+  * Done by SCPIDevice::readBlock; a response that is not a block is read to its end
+  * and dropped.
+  *
+  * @param values Is the storage for the decoded readings.
+  * @param format DATA_FORMAT_REAL32 or DATA_FORMAT_REAL64.
+  * @param swapped True if the instrument was programmed with :FORM:BORD SWAP.
+  * @return EXIT_SUCCESS, a GPIB error status, or -1 if the response is not a binary block.
+  */
+int Gpib::readBinaryBlock(QVector<double> &values, const int format, const bool swapped)
+{
+    QMutexLocker locker(&mutex);
+    // The whole block in one transaction
+    GPIBBusLock bus( BOARD_INDEX, address, BUS_PRIORITY_BULK );
+    values.clear();
+    if( !noError ) return -1;
+
+    int status = core.readBlock( values, format, swapped, [&]( const char *data, int count ){
+        GPIBTrace::transfer( address, GPIB_TRACE_READ, core.status().ibsta, data, count );
+    } );
+    lastStatus = core.status();
+    errors();
+    return noError ? status : -1;
 }
 
 /**
@@ -68,19 +105,18 @@ void Gpib::read(char * message, int size){
   */
 
 int Gpib::checkPresence(){
+    QMutexLocker locker(&mutex);
     int status = EXIT_SUCCESS;
 
-#ifndef TEST
     QString output = QString( "*IDN?" );
 
-    if( Gpib::isNoError() )
+    if( isNoError() )
     {
-        Gpib::write( output.toLocal8Bit().data());
+        write( output.toLocal8Bit().data());
     }
     status = errors();
-    Gpib::read(200);
+    read(200);
     status = errors();
-#endif
     return status;
 }
 
@@ -92,28 +128,25 @@ int Gpib::checkPresence(){
   */
 
 int Gpib::open(int pad, int eos){
-    int status = EXIT_SUCCESS;
-#ifndef TEST
-    short listen;
+    QMutexLocker locker(&mutex);
+    address = pad;
 
-    if( noError ){
-        int v;
-        std::cout<<"Looking for the GPIB Interface"<<std::endl;
-        ibask(BOARD_INDEX,1,&v);
-        status = errors();
-    }
-    if( noError ){
-        std::cout<<"****************************************************************************"<<device<<std::endl;
-        device = ibdev(BOARD_INDEX, pad, SAD, TIMEOUT, EOT, eos);
-        //std::cout<<"****************************************************************************"<<device<<std::endl;
-        status = errors();
+    // Opening again is the way out of an error, so the device starts clean: the
+    // previous descriptor is given back and a new one is always acquired
+    setNoError(true);
+    if( device >= 0 ){
+        GPIBDescriptorPool::instance()->release( driver, device );
+        device = -1;
     }
-    if( noError ){
-        ibln( 0, pad, SAD, &listen);
-        //std::cout<<"****************************************************************************"<<a<<std::endl;
-        status = errors();
+
+    lastStatus = GPIBDescriptorPool::instance()->acquire( driver, BOARD_INDEX, pad, SAD, TIMEOUT, EOT, eos, device );
+    if( !lastStatus.isError() && device < 0 ){
+        lastStatus.ibsta |= ERR;
+        lastStatus.iberr = EDVR;
     }
-#endif
+    core.attach( driver, device );
+    GPIBTrace::event( pad, GPIB_TRACE_OPEN, lastStatus.ibsta, device );
+    int status = errors();
     setNoError(true);
     return status;
 }
@@ -124,12 +157,30 @@ int Gpib::open(int pad, int eos){
   * @param instruction A char sequence that contains the GPIB instruction desired.
   */
 void Gpib::write(char * instruction){
-#ifndef TEST
+    QMutexLocker locker(&mutex);
+    GPIBBusLock bus( BOARD_INDEX, address, BUS_PRIORITY_NORMAL );
     if( noError){
-        ibwrt( device, instruction, strlen(instruction) );
+        core.write( instruction );
+        lastStatus = core.status();
+        GPIBTrace::transfer( address, GPIB_TRACE_WRITE, lastStatus.ibsta, instruction, lastStatus.ibcnt );
+        errors();
+    }
+}
+
+/**
+  * @brief Write a command built by a SCPICommandTemplate.
+  *
+  * @param command The command, sent as is without a copy.
+  */
+void Gpib::write(const SCPICommand &command){
+    QMutexLocker locker(&mutex);
+    GPIBBusLock bus( BOARD_INDEX, address, BUS_PRIORITY_NORMAL );
+    if( noError){
+        core.write( command );
+        lastStatus = core.status();
+        GPIBTrace::transfer( address, GPIB_TRACE_WRITE, lastStatus.ibsta, command.constData(), lastStatus.ibcnt );
         errors();
     }
-#endif
 }
 
 /**
@@ -137,13 +188,13 @@ void Gpib::write(char * instruction){
   */
 void Gpib::remoteEnable()
 {
-#ifndef TEST
+    QMutexLocker locker(&mutex);
+    GPIBBusLock bus( BOARD_INDEX, address, BUS_PRIORITY_NORMAL );
     if( noError ){
         //ibsre( device, 1 ); // depracated
-        ibconfig( device, IbcSRE, 1);
+        lastStatus = driver->config( device, IbcSRE, 1 );
         errors();
     }
-#endif
 }
 
 /**
@@ -151,12 +202,13 @@ void Gpib::remoteEnable()
   */
 void Gpib::clear()
 {
-#ifndef TEST
+    QMutexLocker locker(&mutex);
+    GPIBBusLock bus( BOARD_INDEX, address, BUS_PRIORITY_NORMAL );
     if( noError){
-        ibclr( device );
+        lastStatus = driver->clear( device );
+        GPIBTrace::event( address, GPIB_TRACE_CLEAR, lastStatus.ibsta, 0 );
         errors();
     }
-#endif
 }
 
 /**
@@ -164,47 +216,73 @@ void Gpib::clear()
   */
 
 void Gpib::close(){
-#ifndef TEST
+    QMutexLocker locker(&mutex);
+    GPIBBusLock bus( BOARD_INDEX, address, BUS_PRIORITY_NORMAL );
     // Force the device into local mode
     if( noError ){
-        ibloc( device );
+        lastStatus = driver->goToLocal( device );
         errors(); // Just check for errors if there is no previous errors
         // avoids errors loops
     }
-#endif
 }
 
 /**
   * @brief Close device
+  *
+  * The descriptor goes back to the pool, which takes it offline once it is idle.
   */
 
 void Gpib::disable(){
-#ifndef TEST
-    // Force the device into local mode
-    if( noError ){
-        ibonl(device, 0);
-        errors();
+    QMutexLocker locker(&mutex);
+    if( device >= 0 ){
+        GPIBDescriptorPool::instance()->release( driver, device );
+        device = -1;
     }
-#endif
+    core.attach( driver, -1 );
 }
 
 bool Gpib::isNoError() {return noError;}
 
 void Gpib::setNoError(bool state) {noError = state;}
 
+int Gpib::getDevice() const {return device;}
+
+/**
+  * @brief Set the backend the device is reached through. Call it before open.
+  *
+  * @param driver A GPIBDriver, e.g. a SimulatedK24xx. It is not owned.
+  */
+void Gpib::setDriver(GPIBDriver *driver)
+{
+    QMutexLocker locker(&mutex);
+    if( device >= 0 ) GPIBDescriptorPool::instance()->release( this->driver, device );
+    this->driver = driver;
+    device = -1;
+    core.attach( driver, -1 );
+}
+
+GPIBDriver *Gpib::getDriver() {return driver;}
+
+/**
+  * @brief Mutex serialising the I/O of this device.
+  *
+  * Lock it to keep a write and the following read together when several threads
+  * share the same instance. It is recursive, so Gpib calls can be made while holding it.
+  */
+QRecursiveMutex *Gpib::ioMutex() {return &mutex;}
+
 /**
   * @brief Detect if a GPIB error just happened.
   */
 
 int Gpib::errors(){
     int status = EXIT_SUCCESS;
-#ifndef TEST
 
-    if( ( ibsta & ERR ) == ERR ) {
+    if( lastStatus.isError() ) {
         //We have and error!
         //Extracting type of error
         QString errorMessageText = "GPIB Error: ";
-        switch( iberr ){
+        switch( lastStatus.iberr ){
         case EDVR:
             errorMessageText.append("System error.");
             status = -1;break;
@@ -256,7 +334,6 @@ int Gpib::errors(){
         }
         errorMessage( errorMessageText );
     }
-#endif
     return status;
 }
 
@@ -276,5 +353,5 @@ void Gpib::errorMessage(QString errorType)
     //errorBox.setText( errorType.toLocal8Bit().constData());
     //errorBox.exec();
     setNoError(false);
-    //emit errorSignal();
+    emit errorSignal();
 }
@@ -15,49 +15,69 @@
   */
 #define EOS 0
 
-#ifndef TEST
-    #ifdef  NI_PCI_GPIB
-        #include <windows.h>
-        #include "gpib/ni488.h"
-    #elif   AD_GPIB
-        #include "../GPIB/Adgpib.h"
-        #include "../GPIB/gpib_user.h"
-    #endif
-#endif
+#include "../GPIB/parallelCommunications/gpib/gpibDriver.h"
+#include "../GPIB/parallelCommunications/gpib/gpibBusScheduler.h"
+#include "../GPIB/parallelCommunications/gpib/gpibDescriptorPool.h"
+#include "../GPIB/parallelCommunications/gpib/gpibTrace.h"
 
 #include <QString>
 #include <QObject>
 #include <QVariant>
+#include <QVector>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QFile>
 #include <QTextStream>
 #include "iostream"
 
+#include "../GPIB/ieee4882Block.h"
+#include "../GPIB/scpiDevice.h"
+
 
 //Low level GPIB-driver communication class
+//One instance per device: every instance keeps its own descriptor and error state
+//Qt adapter of SCPIDevice, which does the transfers
+//The transfers share the bus with the ones of GPIBPort through GPIBBusScheduler
 class Gpib:public QObject
 {
     Q_OBJECT
 
 public:
+    Gpib(QObject *parent = 0);
+    ~Gpib();
+
+    void close();
+    void disable();
+    int open( int pad, int eos = 0 );
+    int checkPresence();
+    void write( char *instruction );
+    void write( const SCPICommand &command );
+    QVariant read(const int size = 42 );
+    void read( char * message, int size );
+    int readBinaryBlock( QVector<double> &values, const int format, const bool swapped );
+    void remoteEnable();
+    void clear();
+    bool isNoError();
+    void setNoError(bool state);
 
-    static void close();
-    static void disable();
-    static int open( int pad, int eos = 0 );
-    static int checkPresence();
-    static void write( char *instruction );
-    static QVariant read(const int size = 42 );
-    static void read( char * message, int size );
-    static void remoteEnable();
-    static void clear();
-    static bool isNoError();
-    static void setNoError(bool state);
+    int getDevice() const;
+    QRecursiveMutex *ioMutex();
 
+    void setDriver( GPIBDriver *driver );
+    GPIBDriver *getDriver();
 
 private:
+    int device;
+    int address;
+    bool noError;
+    GPIBDriver *driver;
+    GPIBStatus lastStatus;
+    SCPIDevice core;
+    QRecursiveMutex mutex;
 
 protected:
-    static int errors();
-    static void errorMessage( QString errorType );
+    int errors();
+    void errorMessage( QString errorType );
 
 signals:
     void errorSignal();
@@ -0,0 +1,72 @@
+# GPIB layer, included by the application project from its root directory:
+#
+#     include(gpib/gpib.pri)
+#
+# The sources include each other from that root ("./gpib/...", "../GPIB/..."), as
+# well as debugTools, models and Instruments of the application.
+#
+# The backend is selected with one of
+#     DEFINES += NI_PCI_GPIB     NI-488.2 (gpib-32.obj)
+#     DEFINES += AD_GPIB         ADLINK
+#     DEFINES += LINUX_GPIB      linux-gpib (libgpib)
+#     DEFINES += TEST            in process SimulatedK24xx, no board needed
+
+# QRecursiveMutex needs Qt 5.14
+QT += core
+# SCPICommand.h and scpiDevice.h use std::string_view and std::to_chars
+CONFIG += c++17
+
+HEADERS += \
+    $$PWD/Adgpib.h \
+    $$PWD/callbackFunctions.h \
+    $$PWD/gpib.h \
+    $$PWD/gpib_user.h \
+    $$PWD/ieee4882Block.h \
+    $$PWD/ni488.h \
+    $$PWD/readingBuffer.h \
+    $$PWD/scpi.h \
+    $$PWD/SCPICommand.h \
+    $$PWD/SCPICommandBatch.h \
+    $$PWD/SCPICommandFactory.h \
+    $$PWD/scpiDevice.h \
+    $$PWD/scpiNumericParser.h \
+    $$PWD/SCPIStateCache.h \
+    $$PWD/sweepRunner.h \
+    $$PWD/parallelCommunications/communicationPort.h \
+    $$PWD/parallelCommunications/parallelport.h \
+    $$PWD/parallelCommunications/gpib/gpibBusScheduler.h \
+    $$PWD/parallelCommunications/gpib/gpibDescriptorPool.h \
+    $$PWD/parallelCommunications/gpib/gpibDriver.h \
+    $$PWD/parallelCommunications/gpib/gpibErrorQueue.h \
+    $$PWD/parallelCommunications/gpib/gpibLatencyStats.h \
+    $$PWD/parallelCommunications/gpib/gpibNativeDriver.h \
+    $$PWD/parallelCommunications/gpib/gpibPort.h \
+    $$PWD/parallelCommunications/gpib/gpibQueryPipeline.h \
+    $$PWD/parallelCommunications/gpib/gpibTrace.h \
+    $$PWD/parallelCommunications/gpib/simulatedK24xx.h
+
+SOURCES += \
+    $$PWD/gpib.cpp \
+    $$PWD/readingBuffer.cpp \
+    $$PWD/scpi.cpp \
+    $$PWD/SCPICommandBatch.cpp \
+    $$PWD/SCPICommandFactory.cpp \
+    $$PWD/scpiNumericParser.cpp \
+    $$PWD/SCPIStateCache.cpp \
+    $$PWD/sweepRunner.cpp \
+    $$PWD/parallelCommunications/gpib/gpibBusScheduler.cpp \
+    $$PWD/parallelCommunications/gpib/gpibDescriptorPool.cpp \
+    $$PWD/parallelCommunications/gpib/gpibDriver.cpp \
+    $$PWD/parallelCommunications/gpib/gpibErrorQueue.cpp \
+    $$PWD/parallelCommunications/gpib/gpibLatencyStats.cpp \
+    $$PWD/parallelCommunications/gpib/gpibNativeDriver.cpp \
+    $$PWD/parallelCommunications/gpib/gpibPort.cpp \
+    $$PWD/parallelCommunications/gpib/gpibQueryPipeline.cpp \
+    $$PWD/parallelCommunications/gpib/gpibTrace.cpp \
+    $$PWD/parallelCommunications/gpib/simulatedK24xx.cpp
+
+contains(DEFINES, NI_PCI_GPIB): LIBS += $$PWD/gpib-32.obj
+contains(DEFINES, LINUX_GPIB) {
+    LIBS += -lgpib
+    CONFIG += thread
+}
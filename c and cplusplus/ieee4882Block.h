@@ -0,0 +1,122 @@
+#ifndef IEEE4882BLOCK_H
+#define IEEE4882BLOCK_H
+
+#include <cstring>
+
+/**
+  * Binary data formats selected with :FORM:DATA
+  */
+#define DATA_FORMAT_ASCII   0
+#define DATA_FORMAT_REAL32  1
+#define DATA_FORMAT_REAL64  2
+
+/**
+  * Bytes read from the bus at a time while reading a block
+  */
+#define IEEE_BLOCK_CHUNK_SIZE   4096
+
+/**
+  * Most values reserved up front from the length in a block header; a larger block
+  * grows the storage as its data arrives
+  */
+#define IEEE_BLOCK_RESERVE_LIMIT 65536
+
+/**
+  * @brief Size in bytes of a single value for a :FORM:DATA format.
+  *
+  * @return 4 for REAL,32, 8 for REAL,64 and 0 for ASCii (not a binary format).
+  */
+inline int ieeeBlockValueSize(const int format)
+{
+    switch ( format ) {
+    case DATA_FORMAT_REAL32:
+        return 4;
+    case DATA_FORMAT_REAL64:
+        return 8;
+    default:
+        return 0;
+    }
+}
+
+/**
+  * @brief Parse an IEEE 488.2 block header "#<n><len>".
+  *
+  * A definite length block has n in 1..9 followed by n ascii digits with the
+  * payload length. The indefinite length form "#0" (used by the 24xx series)
+  * ends at END (EOI) instead.
+  *
+  * @param data Buffer starting with the '#' character.
+  * @param size Number of valid bytes in data.
+  * @param payloadLength Set to the payload length, or -1 for "#0" blocks.
+  * @return The header length in bytes, 0 if more bytes are needed or -1 if data is not a block.
+  */
+inline int ieeeBlockHeader(const char *data, const int size, long *payloadLength)
+{
+    if( size < 2 ) return 0;
+    if( data[0] != '#' || data[1] < '0' || data[1] > '9' ) return -1;
+
+    int digits = data[1] - '0';
+    if( digits == 0 ){
+        *payloadLength = -1;
+        return 2;
+    }
+    if( size < 2 + digits ) return 0;
+
+    long length = 0;
+    for( int i = 0; i < digits; i++ ){
+        char c = data[2 + i];
+        if( c < '0' || c > '9' ) return -1;
+        length = length * 10 + ( c - '0' );
+    }
+    *payloadLength = length;
+    return 2 + digits;
+}
+
+/**
+  * @brief Decode a REAL,32 or REAL,64 payload into doubles.
+  *
+  * @param payload The block payload (header already removed).
+  * @param length Payload length in bytes. A trailing partial value is ignored.
+  * @param format DATA_FORMAT_REAL32 or DATA_FORMAT_REAL64.
+  * @param swapped True when the instrument sends the data with :FORM:BORD SWAP (little endian).
+  * @param values Destination array.
+  * @param capacity Maximum number of values to store in values.
+  * @return The number of decoded values.
+  */
+inline int ieeeBlockDecode(const char *payload, const long length, const int format,
+                           const bool swapped, double *values, const int capacity)
+{
+    const int valueSize = ieeeBlockValueSize(format);
+    if( valueSize == 0 ) return 0;
+
+    const unsigned short probe = 1;
+    const bool hostIsLittleEndian = *reinterpret_cast<const unsigned char *>(&probe) == 1;
+    const bool reverse = ( swapped != hostIsLittleEndian );
+
+    int count = (int)( length / valueSize );
+    if( count > capacity ) count = capacity;
+
+    unsigned char bytes[8];
+    for( int i = 0; i < count; i++ ){
+        const char *source = payload + i * valueSize;
+        if( reverse ){
+            for( int b = 0; b < valueSize; b++ )
+                bytes[b] = source[valueSize - 1 - b];
+        } else {
+            memcpy( bytes, source, valueSize );
+        }
+
+        if( valueSize == 8 ){
+            double value;
+            memcpy( &value, bytes, 8 );
+            values[i] = value;
+        } else {
+            float value;
+            memcpy( &value, bytes, 4 );
+            values[i] = value;
+        }
+    }
+    return count;
+}
+
+#endif // IEEE4882BLOCK_H
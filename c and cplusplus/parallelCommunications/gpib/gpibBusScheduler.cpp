@@ -0,0 +1,186 @@
+#include "./gpib/parallelCommunications/gpib/gpibBusScheduler.h"
+
+#define GPIB_MAX_BOARDS 16
+
+GPIBBusScheduler::GPIBBusScheduler()
+{
+    nextTicket = 1;
+    grantedTicket = 0;
+    busy = false;
+    ownerThread = 0;
+    ownerDepth = 0;
+    transfers = 0;
+    lastAddress = -1;
+    burst = 0;
+}
+
+/**
+  * @brief Get the scheduler of a GPIB board.
+  *
+  * @param boardIndex The board index used with ibdev.
+  */
+GPIBBusScheduler *GPIBBusScheduler::board(int boardIndex)
+{
+    static GPIBBusScheduler schedulers[GPIB_MAX_BOARDS];
+
+    if( boardIndex < 0 || boardIndex >= GPIB_MAX_BOARDS ) boardIndex = 0;
+    return &schedulers[boardIndex];
+}
+
+/**
+  * @brief Wait until the bus is granted to the calling thread.
+  *
+  * @param address The primary address of the device that is going to be used.
+  * @param priority The priority class of the transaction (BUS_PRIORITY_*).
+  */
+void GPIBBusScheduler::acquire(int address, int priority)
+{
+    QMutexLocker locker(&mutex);
+    QThread *thread = QThread::currentThread();
+
+    if( busy && ownerThread == thread ){
+        ownerDepth++;
+        return;
+    }
+
+    Waiter waiter;
+    waiter.ticket = nextTicket++;
+    waiter.address = address;
+    waiter.priority = priority;
+    waiters.append(waiter);
+
+    if( !busy ) grantNext(-1);
+    while( grantedTicket != waiter.ticket )
+        granted.wait(&mutex);
+
+    ownerThread = thread;
+    ownerDepth = 1;
+}
+
+/**
+  * @brief Release the bus taken with acquire.
+  */
+void GPIBBusScheduler::release()
+{
+    QMutexLocker locker(&mutex);
+
+    if( --ownerDepth > 0 ) return;
+
+    ownerThread = 0;
+    if( transfers > 0 ) return;
+
+    busy = false;
+    grantedTicket = 0;
+    if( !waiters.isEmpty() ) grantNext(-1);
+}
+
+/**
+  * @brief Keep the bus, held by the calling thread, for an asynchronous transfer.
+  *
+  * Call it after the transfer has started. The bus stays taken when the thread
+  * releases it, until finishTransfer is called, usually from the driver
+  * notification thread.
+  */
+void GPIBBusScheduler::holdForTransfer()
+{
+    QMutexLocker locker(&mutex);
+    transfers++;
+}
+
+/**
+  * @brief The asynchronous transfer given the bus with holdForTransfer has ended.
+  */
+void GPIBBusScheduler::finishTransfer()
+{
+    QMutexLocker locker(&mutex);
+
+    if( transfers > 0 ) transfers--;
+    if( transfers > 0 || ownerDepth > 0 ) return;
+
+    busy = false;
+    ownerThread = 0;
+    grantedTicket = 0;
+    if( !waiters.isEmpty() ) grantNext(-1);
+}
+
+/**
+  * @brief Let more urgent transactions of other devices use the bus.
+  *
+  * Meant to be called between the chunks of a long transfer. The device being read
+  * keeps its output queue, so the transfer can go on once the bus comes back.
+  * Only waiters of a higher priority class and another address are let through.
+  *
+  * @return true if the bus was handed over and taken again.
+  */
+bool GPIBBusScheduler::yield(int address, int priority)
+{
+    QMutexLocker locker(&mutex);
+
+    bool urgent = false;
+    for( int i = 0; i < waiters.size() && !urgent; i++ )
+        urgent = waiters.at(i).priority < priority && waiters.at(i).address != address;
+    if( !urgent ) return false;
+
+    QThread *thread = QThread::currentThread();
+    int depth = ownerDepth;
+
+    // Queue again ahead of the waiters of the same class
+    Waiter waiter;
+    waiter.ticket = nextTicket++;
+    waiter.address = address;
+    waiter.priority = priority;
+    waiters.prepend(waiter);
+
+    busy = false;
+    ownerThread = 0;
+    grantNext(address);
+
+    while( grantedTicket != waiter.ticket )
+        granted.wait(&mutex);
+
+    ownerThread = thread;
+    ownerDepth = depth;
+    return true;
+}
+
+/**
+  * @brief Grant the bus to the next waiter.
+  *
+  * @param excludedAddress Address that must not be granted now, -1 for none.
+  */
+void GPIBBusScheduler::grantNext(int excludedAddress)
+{
+    int best = -1;
+    for( int i = 0; i < waiters.size(); i++ ){
+        const Waiter &w = waiters.at(i);
+        if( w.address == excludedAddress ) continue;
+        if( best < 0 || w.priority < waiters.at(best).priority ) best = i;
+    }
+    if( best < 0 ){
+        // Only the excluded address is waiting
+        if( waiters.isEmpty() ) return;
+        best = 0;
+    }
+
+    // Same listener as the last transaction, if it is waiting in the same class
+    if( burst < BUS_SAME_LISTENER_BURST ){
+        for( int i = 0; i < waiters.size(); i++ ){
+            const Waiter &w = waiters.at(i);
+            if( w.address == lastAddress && w.address != excludedAddress
+                    && w.priority == waiters.at(best).priority ){
+                best = i;
+                break;
+            }
+        }
+    }
+
+    Waiter next = waiters.at(best);
+    waiters.removeAt(best);
+
+    burst = ( next.address == lastAddress ) ? burst + 1 : 0;
+    lastAddress = next.address;
+    grantedTicket = next.ticket;
+    busy = true;
+    ownerThread = 0;
+    granted.wakeAll();
+}
@@ -0,0 +1,90 @@
+#ifndef GPIBBUSSCHEDULER_H
+#define GPIBBUSSCHEDULER_H
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThread>
+#include <QList>
+
+/**
+  * Bus priority classes. Lower value is served first.
+  *  - CRITICAL = interlock and status polls
+  *  - NORMAL = configuration and single readings
+  *  - BULK = buffer dumps (:TRAC:DATA?)
+  */
+#define BUS_PRIORITY_CRITICAL   0
+#define BUS_PRIORITY_NORMAL     1
+#define BUS_PRIORITY_BULK       2
+
+/**
+  * Maximum number of consecutive grants given to the same listener while other
+  * devices of the same priority are waiting.
+  */
+#define BUS_SAME_LISTENER_BURST 8
+
+/**
+  * @brief Serialises the transactions of all the devices of one GPIB board.
+  *
+  * There is one scheduler per board index. Waiting transactions are served by
+  * priority class, FIFO inside a class, preferring the listener that used the bus
+  * last so back-to-back writes to the same device go together. The bus can be
+  * taken recursively by the thread that owns it. An asynchronous transfer keeps the
+  * bus from its start until its notification (holdForTransfer, finishTransfer).
+  */
+class GPIBBusScheduler
+{
+public:
+    static GPIBBusScheduler *board(int boardIndex);
+
+    void acquire(int address, int priority);
+    void release();
+    bool yield(int address, int priority);
+    void holdForTransfer();
+    void finishTransfer();
+
+private:
+    GPIBBusScheduler();
+
+    struct Waiter
+    {
+        quint64 ticket;
+        int     address;
+        int     priority;
+    };
+
+    void grantNext(int excludedAddress);
+
+    QMutex          mutex;
+    QWaitCondition  granted;
+    QList<Waiter>   waiters;
+    quint64         nextTicket;
+    quint64         grantedTicket;
+    bool            busy;
+    QThread        *ownerThread;
+    int             ownerDepth;
+    int             transfers;
+    int             lastAddress;
+    int             burst;
+};
+
+/**
+  * @brief Holds the bus of a board for the lifetime of the object.
+  */
+class GPIBBusLock
+{
+public:
+    GPIBBusLock(int boardIndex, int address, int priority)
+    {
+        scheduler = GPIBBusScheduler::board(boardIndex);
+        scheduler->acquire(address, priority);
+    }
+    ~GPIBBusLock()
+    {
+        scheduler->release();
+    }
+
+private:
+    GPIBBusScheduler *scheduler;
+};
+
+#endif // GPIBBUSSCHEDULER_H
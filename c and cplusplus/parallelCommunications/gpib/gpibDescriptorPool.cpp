@@ -0,0 +1,202 @@
+#include "./gpib/parallelCommunications/gpib/gpibDescriptorPool.h"
+
+#include <iostream>
+
+GPIBDescriptorPool::GPIBDescriptorPool()
+{
+    idleTimeout = DESCRIPTOR_IDLE_TIMEOUT;
+}
+
+/**
+  * @brief Get the pool of the process.
+  */
+GPIBDescriptorPool *GPIBDescriptorPool::instance()
+{
+    static GPIBDescriptorPool pool;
+    return &pool;
+}
+
+/**
+  * @brief Get a descriptor for a device, opening it only if none is free in the pool.
+  *
+  * @param driver The backend the descriptor belongs to.
+  * @param timo The I/O timeout wanted. It is applied to a reused descriptor if it differs.
+  * @param ud Set to the descriptor.
+  * @return The status of the last driver call, or CMPL if none was needed.
+  */
+GPIBStatus GPIBDescriptorPool::acquire(GPIBDriver *driver, int boardIndex, int pad, int sad, int timo, int eot, int eos, int &ud)
+{
+    QMutexLocker locker(&mutex);
+    GPIBStatus status;
+    status.ibsta = CMPL;
+
+    closeExpired();
+
+    for( int i = 0; i < entries.size(); i++ ){
+        Entry &entry = entries[i];
+        if( entry.driver != driver || entry.boardIndex != boardIndex || entry.pad != pad
+                || entry.sad != sad || entry.eos != eos || entry.inUse ) continue;
+
+        if( !isAlive( entry ) ){
+            close( i );
+            break;
+        }
+        if( entry.timo != timo ){
+            status = driver->setTimeout( entry.ud, timo );
+            if( status.isError() ) return status;
+            entry.timo = timo;
+        }
+        entry.inUse = true;
+        entry.lastUsed.start();
+        ud = entry.ud;
+        return status;
+    }
+
+    // The board is only queried the first time
+    bool boardFound = false;
+    for( int i = 0; i < boards.size() && !boardFound; i++ )
+        boardFound = boards.at(i).driver == driver && boards.at(i).boardIndex == boardIndex;
+    if( !boardFound ){
+        int v;
+        std::cout<<"Looking for the GPIB Interface"<<std::endl;
+        status = driver->ask( boardIndex, 1, &v );
+        if( status.isError() ) return status;
+
+        Board board;
+        board.driver = driver;
+        board.boardIndex = boardIndex;
+        boards.append( board );
+    }
+
+    status = driver->openDevice( boardIndex, pad, sad, timo, eot, eos, ud );
+    if( status.isError() ) return status;
+
+    Entry entry;
+    entry.driver = driver;
+    entry.boardIndex = boardIndex;
+    entry.pad = pad;
+    entry.sad = sad;
+    entry.eos = eos;
+    entry.ud = ud;
+    entry.timo = timo;
+    entry.inUse = true;
+    entry.lastUsed.start();
+    entries.append( entry );
+
+    // Check the listener (the instrument, not the board) is present
+    short listen;
+    return driver->findListener( boardIndex, pad, sad, &listen );
+}
+
+/**
+  * @brief Give back a descriptor taken with acquire. It stays open until it is idle.
+  */
+void GPIBDescriptorPool::release(GPIBDriver *driver, int ud)
+{
+    QMutexLocker locker(&mutex);
+    int index = find( driver, ud );
+    if( index < 0 ) return;
+
+    Entry &entry = entries[index];
+    entry.inUse = false;
+    entry.lastUsed.start();
+
+    closeExpired();
+}
+
+/**
+  * @brief Set the I/O timeout of a descriptor taken with acquire.
+  *
+  * @param timo One of the TIMEOUT_* values.
+  */
+GPIBStatus GPIBDescriptorPool::setTimeout(GPIBDriver *driver, int ud, int timo)
+{
+    QMutexLocker locker(&mutex);
+    GPIBStatus status = driver->setTimeout( ud, timo );
+    int index = find( driver, ud );
+    if( index >= 0 && !status.isError() ) entries[index].timo = timo;
+    return status;
+}
+
+/**
+  * @brief Take offline the descriptors that have not been used for the idle timeout.
+  *
+  * It is also done on every acquire and release, so it only needs to be called to
+  * free the descriptors of a process that stops using the bus.
+  *
+  * @return The number of descriptors closed.
+  */
+int GPIBDescriptorPool::closeIdle()
+{
+    QMutexLocker locker(&mutex);
+    return closeExpired();
+}
+
+/**
+  * @brief Take offline every released descriptor, idle or not.
+  *
+  * The descriptors in use stay open; they are closed once released.
+  */
+void GPIBDescriptorPool::closeAll()
+{
+    QMutexLocker locker(&mutex);
+    for( int i = entries.size() - 1; i >= 0; i-- )
+        if( !entries.at(i).inUse ) close( i );
+}
+
+/**
+  * @brief Time a released descriptor stays open. 0 closes it as soon as it is released.
+  */
+void GPIBDescriptorPool::setIdleTimeout(int milliseconds)
+{
+    QMutexLocker locker(&mutex);
+    idleTimeout = milliseconds;
+}
+
+int GPIBDescriptorPool::getIdleTimeout()
+{
+    QMutexLocker locker(&mutex);
+    return idleTimeout;
+}
+
+int GPIBDescriptorPool::find(GPIBDriver *driver, int ud)
+{
+    for( int i = 0; i < entries.size(); i++ )
+        if( entries.at(i).driver == driver && entries.at(i).ud == ud ) return i;
+    return -1;
+}
+
+/**
+  * @brief Check that the device of a descriptor still listens.
+  *
+  * Only done when the descriptor has not been used for
+  * DESCRIPTOR_LIVENESS_INTERVAL, so a quick reconnect costs no bus traffic.
+  */
+bool GPIBDescriptorPool::isAlive(Entry &entry)
+{
+    if( !entry.lastUsed.hasExpired( DESCRIPTOR_LIVENESS_INTERVAL ) ) return true;
+
+    short listen = 0;
+    GPIBStatus status = entry.driver->findListener( entry.boardIndex, entry.pad, entry.sad, &listen );
+    return !status.isError() && listen != 0;
+}
+
+int GPIBDescriptorPool::closeExpired()
+{
+    int closed = 0;
+    for( int i = entries.size() - 1; i >= 0; i-- ){
+        if( entries.at(i).inUse || !entries.at(i).lastUsed.hasExpired( idleTimeout ) ) continue;
+        close( i );
+        closed++;
+    }
+    return closed;
+}
+
+/**
+  * @brief Take a descriptor offline (ibonl 0) and remove it from the pool.
+  */
+void GPIBDescriptorPool::close(int index)
+{
+    entries.at(index).driver->online( entries.at(index).ud, 0 );
+    entries.removeAt( index );
+}
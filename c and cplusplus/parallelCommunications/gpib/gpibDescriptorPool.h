@@ -0,0 +1,79 @@
+#ifndef GPIBDESCRIPTORPOOL_H
+#define GPIBDESCRIPTORPOOL_H
+
+#include "./gpib/parallelCommunications/gpib/gpibDriver.h"
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+
+/**
+  * Descriptor pool timing
+  *  - DESCRIPTOR_IDLE_TIMEOUT = ms a descriptor nobody uses stays open
+  *  - DESCRIPTOR_LIVENESS_INTERVAL = ms after which a reused descriptor is checked with ibln
+  */
+#define DESCRIPTOR_IDLE_TIMEOUT 60000
+#define DESCRIPTOR_LIVENESS_INTERVAL 5000
+
+/**
+  * @brief Process wide pool of open device descriptors.
+  *
+  * The descriptors are keyed by driver, board, primary and secondary address and
+  * EOS mode. Opening a device whose descriptor was released but is still open
+  * returns it without calling ibdev; the board is only queried (ibask) the first
+  * time. A reused descriptor is checked with ibln when it has not been used for a
+  * while, and opened again if the device is gone. Released descriptors are taken
+  * offline (ibonl 0) once they have been idle for the idle timeout.
+  *
+  * A descriptor has one user at a time: the timeout and the END/EOS settings are
+  * per descriptor, so a device opened twice at once gets two descriptors. Change
+  * the timeout of a pooled descriptor with setTimeout, so the pool knows it.
+  */
+class GPIBDescriptorPool
+{
+public:
+    static GPIBDescriptorPool *instance();
+
+    GPIBStatus acquire( GPIBDriver *driver, int boardIndex, int pad, int sad, int timo, int eot, int eos, int &ud );
+    void       release( GPIBDriver *driver, int ud );
+    GPIBStatus setTimeout( GPIBDriver *driver, int ud, int timo );
+    int        closeIdle();
+    void       closeAll();
+
+    void       setIdleTimeout( int milliseconds );
+    int        getIdleTimeout();
+
+private:
+    GPIBDescriptorPool();
+
+    struct Entry
+    {
+        GPIBDriver   *driver;
+        int           boardIndex;
+        int           pad;
+        int           sad;
+        int           eos;
+        int           ud;
+        int           timo;
+        bool          inUse;
+        QElapsedTimer lastUsed;
+    };
+
+    struct Board
+    {
+        GPIBDriver *driver;
+        int         boardIndex;
+    };
+
+    int        find( GPIBDriver *driver, int ud );
+    bool       isAlive( Entry &entry );
+    int        closeExpired();
+    void       close( int index );
+
+    QMutex       mutex;
+    QList<Entry> entries;
+    QList<Board> boards;
+    int          idleTimeout;
+};
+
+#endif // GPIBDESCRIPTORPOOL_H
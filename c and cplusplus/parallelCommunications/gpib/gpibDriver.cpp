@@ -0,0 +1,38 @@
+#include "./gpib/parallelCommunications/gpib/gpibDriver.h"
+
+#ifndef TEST
+    #include "./gpib/parallelCommunications/gpib/gpibNativeDriver.h"
+#else
+    #include "./gpib/parallelCommunications/gpib/simulatedK24xx.h"
+#endif
+
+static GPIBDriver *installedDriver = 0;
+
+/**
+  * @brief Backend given to the ports created from now on.
+  *
+  * It is the board driver, or a simulated SourceMeter in TEST builds, unless another
+  * one has been set with setDefaultDriver.
+  */
+GPIBDriver *GPIBDriver::defaultDriver()
+{
+    if( installedDriver ) return installedDriver;
+
+#ifndef TEST
+    static GPIBNativeDriver nativeDriver;
+    return &nativeDriver;
+#else
+    static SimulatedK24xx simulatedDriver;
+    return &simulatedDriver;
+#endif
+}
+
+/**
+  * @brief Set the backend of the ports created from now on. 0 restores the default one.
+  *
+  * @param driver It is not owned and must outlive the ports that use it.
+  */
+void GPIBDriver::setDefaultDriver(GPIBDriver *driver)
+{
+    installedDriver = driver;
+}
@@ -0,0 +1,99 @@
+#ifndef GPIBDRIVER_H
+#define GPIBDRIVER_H
+
+#ifndef TEST
+    #ifdef  NI_PCI_GPIB
+        #include <windows.h>
+        #include "gpib/ni488.h"
+    #elif   AD_GPIB
+        #include "./gpib/Adgpib.h"
+        #include "./gpib/gpib_user.h"
+    #elif   LINUX_GPIB
+        // linux-gpib, link with -lgpib
+        #include <gpib/ib.h>
+        #ifndef __stdcall
+            #define __stdcall
+        #endif
+    #endif
+#else
+    // Status bits, error codes and timeouts for the simulated instruments
+    #include "./gpib/gpib_user.h"
+#endif
+
+#include "./gpib/callbackFunctions.h"
+
+/**
+  * @brief Status of one driver call: the ibsta, iberr and ibcntl it left.
+  *
+  * It is captured right after the call, so it can not be overwritten by the calls
+  * of other devices or threads.
+  */
+struct GPIBStatus
+{
+    int  ibsta;
+    int  iberr;
+    long ibcnt;
+
+    GPIBStatus()
+    {
+        ibsta = 0;
+        iberr = 0;
+        ibcnt = 0;
+    }
+
+    bool isError() const { return ( ibsta & ERR ) == ERR; }
+    bool isTimeout() const { return ( ibsta & TIMO ) == TIMO; }
+    bool isEnd() const { return ( ibsta & END ) == END; }
+};
+
+/**
+  * @brief Length of a text response without the terminator ("\n" or "\r\n") sent with END.
+  *
+  * @param data The bytes read.
+  * @param count The number of bytes read, from ibcnt.
+  */
+inline long stripTerminator( const char *data, long count )
+{
+    if( count > 0 && data[count - 1] == '\n' ) count--;
+    if( count > 0 && data[count - 1] == '\r' ) count--;
+    return count;
+}
+
+/**
+  * @brief Backend used by GPIBPort and Gpib to talk to the bus.
+  *
+  * Every method maps to one NI-488.2 style call (named in its comment) and returns
+  * the status it left. The native backend calls the driver of the board, other
+  * backends simulate the bus and the instruments in process.
+  */
+class GPIBDriver
+{
+public:
+    virtual ~GPIBDriver(){}
+
+    virtual GPIBStatus ask( int ud, int option, int *value ) = 0;                               // ibask
+    virtual GPIBStatus config( int ud, int option, int value ) = 0;                             // ibconfig
+    virtual GPIBStatus openDevice( int boardIndex, int pad, int sad, int timo, int eot, int eos, int &ud ) = 0; // ibdev
+    virtual GPIBStatus online( int ud, int value ) = 0;                                         // ibonl
+    virtual GPIBStatus clear( int ud ) = 0;                                                     // ibclr
+    virtual GPIBStatus goToLocal( int ud ) = 0;                                                 // ibloc
+    virtual GPIBStatus findListener( int ud, int pad, int sad, short *listen ) = 0;             // ibln
+    virtual GPIBStatus setPrimaryAddress( int ud, int pad ) = 0;                                // ibpad
+    virtual GPIBStatus setSecondaryAddress( int ud, int sad ) = 0;                              // ibsad
+    virtual GPIBStatus interfaceClear( int ud ) = 0;                                            // ibsic
+    virtual GPIBStatus remoteEnable( int ud, int value ) = 0;                                   // ibsre
+    virtual GPIBStatus setTimeout( int ud, int timo ) = 0;                                      // ibtmo
+    virtual GPIBStatus write( int ud, const char *data, long count ) = 0;                       // ibwrt
+    virtual GPIBStatus read( int ud, char *buffer, long count ) = 0;                            // ibrd
+    virtual GPIBStatus wait( int ud, int mask ) = 0;                                            // ibwait
+    virtual GPIBStatus serialPoll( int ud, char *spr ) = 0;                                     // ibrsp
+    virtual GPIBStatus writeAsync( int ud, const char *data, long count ) = 0;                  // ibwrta
+    virtual GPIBStatus readAsync( int ud, char *buffer, long count ) = 0;                       // ibrda
+    virtual GPIBStatus notify( int ud, int mask, GpibNotifyReceiver *receiver ) = 0;            // ibnotify
+    virtual GPIBStatus stop( int ud ) = 0;                                                      // ibstop
+
+    static GPIBDriver *defaultDriver();
+    static void setDefaultDriver( GPIBDriver *driver );
+};
+
+#endif // GPIBDRIVER_H
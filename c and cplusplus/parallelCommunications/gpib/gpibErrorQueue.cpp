@@ -0,0 +1,114 @@
+#include "./gpib/parallelCommunications/gpib/gpibErrorQueue.h"
+
+#define GPIB_ERROR_QUEUE_MASK ( GPIB_ERROR_QUEUE_SIZE - 1 )
+
+/**
+  * @brief Text of a GPIBErrorCode.
+  */
+const char *gpibErrorText(int code)
+{
+    switch( code ){
+    case GPIB_ERROR_NONE:               return "GPIB: No error.";
+    case GPIB_ERROR_SYSTEM:             return "GPIB Error: System error.";
+    case GPIB_ERROR_NOT_CIC:            return "GPIB Error: Function requires GPIB board to be CIC.";
+    case GPIB_ERROR_NO_LISTENERS:       return "GPIB Error: Write function detected no Listeners.";
+    case GPIB_ERROR_NOT_ADDRESSED:      return "GPIB Error: Interface board not addressed correctly.";
+    case GPIB_ERROR_INVALID_ARGUMENT:   return "GPIB Error: Invalid argument to function call.";
+    case GPIB_ERROR_NOT_SAC:            return "GPIB Error: Function requires GPIB board to be SAC.";
+    case GPIB_ERROR_ABORTED:            return "GPIB Error: I/O operation aborted.";
+    case GPIB_ERROR_NO_BOARD:           return "GPIB Error: Non-existent interface board.";
+    case GPIB_ERROR_DMA:                return "GPIB Error: DMA hardware error detected.";
+    case GPIB_ERROR_IN_PROGRESS:        return "GPIB Error: I/O operation started before previous operation completed.";
+    case GPIB_ERROR_NO_CAPABILITY:      return "GPIB Error: No capability for intended operation.";
+    case GPIB_ERROR_FILE_SYSTEM:        return "GPIB Error: File system operation error.";
+    case GPIB_ERROR_BUS:                return "GPIB Error: Command error during device call.";
+    case GPIB_ERROR_STATUS_BYTE_LOST:   return "GPIB Error: Serial poll status byte lost.";
+    case GPIB_ERROR_SRQ_STUCK:          return "GPIB Error: SRQ remains asserted.";
+    case GPIB_ERROR_TABLE_FULL:         return "GPIB Error: The return buffer is full.";
+    case GPIB_ERROR_TIMEOUT:            return "GPIB Error: Timeout waiting for the device response.";
+    default:                            return "GPIB Error: Unknown error.";
+    }
+}
+
+GPIBErrorQueue::GPIBErrorQueue()
+{
+    for( unsigned int i = 0; i < GPIB_ERROR_QUEUE_SIZE; i++ )
+        cells[i].sequence.store( i, std::memory_order_relaxed );
+    enqueuePosition.store( 0, std::memory_order_relaxed );
+    dequeuePosition.store( 0, std::memory_order_relaxed );
+    droppedEvents.store( 0, std::memory_order_relaxed );
+}
+
+/**
+  * @brief Add an event.
+  *
+  * @return false if the queue was full and the event was dropped.
+  */
+bool GPIBErrorQueue::push(const GPIBErrorEvent &event)
+{
+    Cell *cell;
+    unsigned int position = enqueuePosition.load( std::memory_order_relaxed );
+    for( ;; ){
+        cell = &cells[ position & GPIB_ERROR_QUEUE_MASK ];
+        unsigned int sequence = cell->sequence.load( std::memory_order_acquire );
+        int difference = (int)( sequence - position );
+        if( difference == 0 ){
+            if( enqueuePosition.compare_exchange_weak( position, position + 1, std::memory_order_relaxed ) )
+                break;
+        } else if( difference < 0 ){
+            droppedEvents.fetch_add( 1, std::memory_order_relaxed );
+            return false;
+        } else {
+            position = enqueuePosition.load( std::memory_order_relaxed );
+        }
+    }
+
+    cell->event = event;
+    cell->sequence.store( position + 1, std::memory_order_release );
+    return true;
+}
+
+/**
+  * @brief Take the oldest event.
+  *
+  * @return false if the queue is empty.
+  */
+bool GPIBErrorQueue::take(GPIBErrorEvent &event)
+{
+    Cell *cell;
+    unsigned int position = dequeuePosition.load( std::memory_order_relaxed );
+    for( ;; ){
+        cell = &cells[ position & GPIB_ERROR_QUEUE_MASK ];
+        unsigned int sequence = cell->sequence.load( std::memory_order_acquire );
+        int difference = (int)( sequence - ( position + 1 ) );
+        if( difference == 0 ){
+            if( dequeuePosition.compare_exchange_weak( position, position + 1, std::memory_order_relaxed ) )
+                break;
+        } else if( difference < 0 ){
+            return false;
+        } else {
+            position = dequeuePosition.load( std::memory_order_relaxed );
+        }
+    }
+
+    event = cell->event;
+    cell->sequence.store( position + GPIB_ERROR_QUEUE_SIZE, std::memory_order_release );
+    return true;
+}
+
+/**
+  * @brief Discard the pending events.
+  */
+void GPIBErrorQueue::clear()
+{
+    GPIBErrorEvent event;
+    while( take(event) ) {}
+}
+
+/**
+  * @brief Number of events dropped because the queue was full.
+  */
+unsigned int GPIBErrorQueue::dropped() const
+{
+    return droppedEvents.load( std::memory_order_relaxed );
+}
@@ -0,0 +1,85 @@
+#ifndef GPIBERRORQUEUE_H
+#define GPIBERRORQUEUE_H
+
+#include <QtGlobal>
+
+#include <atomic>
+
+/**
+  * GPIB error codes, independent of the driver (NI-488.2 or ADLINK).
+  * They are mapped from iberr, except GPIB_ERROR_TIMEOUT that is set from TIMO.
+  */
+enum GPIBErrorCode
+{
+    GPIB_ERROR_NONE = 0,
+    GPIB_ERROR_SYSTEM,              // EDVR
+    GPIB_ERROR_NOT_CIC,             // ECIC
+    GPIB_ERROR_NO_LISTENERS,        // ENOL
+    GPIB_ERROR_NOT_ADDRESSED,       // EADR
+    GPIB_ERROR_INVALID_ARGUMENT,    // EARG
+    GPIB_ERROR_NOT_SAC,             // ESAC
+    GPIB_ERROR_ABORTED,             // EABO
+    GPIB_ERROR_NO_BOARD,            // ENEB
+    GPIB_ERROR_DMA,                 // EDMA
+    GPIB_ERROR_IN_PROGRESS,         // EOIP
+    GPIB_ERROR_NO_CAPABILITY,       // ECAP
+    GPIB_ERROR_FILE_SYSTEM,         // EFSO
+    GPIB_ERROR_BUS,                 // EBUS
+    GPIB_ERROR_STATUS_BYTE_LOST,    // ESTB
+    GPIB_ERROR_SRQ_STUCK,           // ESRQ
+    GPIB_ERROR_TABLE_FULL,          // ETAB
+    GPIB_ERROR_TIMEOUT,
+    GPIB_ERROR_UNKNOWN
+};
+
+const char *gpibErrorText(int code);
+
+/**
+  * @brief One error reported by a GPIBPort.
+  */
+struct GPIBErrorEvent
+{
+    int     code;       // GPIBErrorCode
+    int     address;    // Primary address of the device
+    int     ibsta;
+    int     iberr;
+    qint64  timestamp;  // Milliseconds, QElapsedTimer::msecsSinceReference()
+};
+
+/**
+  * Number of events kept in a GPIBErrorQueue. Must be a power of two.
+  */
+#define GPIB_ERROR_QUEUE_SIZE 64
+
+/**
+  * @brief Bounded lock-free queue of error events.
+  *
+  * Any thread can push (the I/O thread or the driver notification thread) and any
+  * thread can take. Neither side ever blocks: when the queue is full the new event
+  * is dropped and counted.
+  */
+class GPIBErrorQueue
+{
+public:
+    GPIBErrorQueue();
+
+    bool push(const GPIBErrorEvent &event);
+    bool take(GPIBErrorEvent &event);
+    void clear();
+
+    unsigned int dropped() const;
+
+private:
+    struct Cell
+    {
+        std::atomic<unsigned int> sequence;
+        GPIBErrorEvent event;
+    };
+
+    Cell cells[GPIB_ERROR_QUEUE_SIZE];
+    std::atomic<unsigned int> enqueuePosition;
+    std::atomic<unsigned int> dequeuePosition;
+    std::atomic<unsigned int> droppedEvents;
+};
+
+#endif // GPIBERRORQUEUE_H
@@ -0,0 +1,297 @@
+#include "./gpib/parallelCommunications/gpib/gpibLatencyStats.h"
+
+#include <QList>
+#include <QMutex>
+
+#include <atomic>
+
+#define GPIB_HISTOGRAM_MAX_VALUE ( ( Q_UINT64_C(1) << GPIB_HISTOGRAM_MAX_BITS ) - 1 )
+
+//
+// GPIBLatencyHistogram
+//
+
+GPIBLatencyHistogram::GPIBLatencyHistogram()
+{
+    buckets.resize( GPIB_HISTOGRAM_BUCKETS );
+    clear();
+}
+
+void GPIBLatencyHistogram::clear()
+{
+    buckets.fill( 0 );
+    samples = 0;
+    total = 0;
+    byteCount = 0;
+    minimum = 0;
+    maximum = 0;
+}
+
+/**
+  * @brief Merge the samples of another histogram.
+  */
+void GPIBLatencyHistogram::add(const GPIBLatencyHistogram &other)
+{
+    if( other.samples == 0 ) return;
+
+    for( int i = 0; i < GPIB_HISTOGRAM_BUCKETS; i++ ) buckets[i] += other.buckets.at(i);
+    minimum = ( samples == 0 ) ? other.minimum : qMin( minimum, other.minimum );
+    maximum = qMax( maximum, other.maximum );
+    samples += other.samples;
+    total += other.total;
+    byteCount += other.byteCount;
+}
+
+quint64 GPIBLatencyHistogram::count() const {return samples;}
+
+/**
+  * @brief Bytes transferred by the operations, from ibcnt.
+  */
+quint64 GPIBLatencyHistogram::bytes() const {return byteCount;}
+
+quint64 GPIBLatencyHistogram::min() const {return minimum;}
+
+quint64 GPIBLatencyHistogram::max() const {return maximum;}
+
+double GPIBLatencyHistogram::mean() const {return samples ? (double)total / samples : 0;}
+
+/**
+  * @brief Latency not exceeded by a percentage of the operations, within the bucket resolution.
+  *
+  * @param percentile From 0 to 100.
+  */
+quint64 GPIBLatencyHistogram::valueAtPercentile(double percentile) const
+{
+    if( samples == 0 ) return 0;
+
+    quint64 rank = (quint64)( percentile / 100 * samples + 0.5 );
+    if( rank < 1 ) rank = 1;
+    if( rank > samples ) rank = samples;
+
+    quint64 seen = 0;
+    for( int i = 0; i < GPIB_HISTOGRAM_BUCKETS; i++ ){
+        seen += buckets.at(i);
+        if( seen >= rank ) return qMin( bucketValue( i + 1 ) - 1, maximum );
+    }
+    return maximum;
+}
+
+quint64 GPIBLatencyHistogram::bucketCount(int index) const {return buckets.value( index );}
+
+/**
+  * @brief Bucket of a value in us.
+  */
+int GPIBLatencyHistogram::bucketIndex(quint64 value)
+{
+    if( value > GPIB_HISTOGRAM_MAX_VALUE ) value = GPIB_HISTOGRAM_MAX_VALUE;
+    if( value < GPIB_HISTOGRAM_SUB_BUCKETS ) return (int)value;
+
+    // Position of the most significant bit, by halving
+    int msb = 0;
+    quint64 v = value;
+    if( v >> 32 ){ v >>= 32; msb += 32; }
+    if( v >> 16 ){ v >>= 16; msb += 16; }
+    if( v >> 8 ){ v >>= 8; msb += 8; }
+    if( v >> 4 ){ v >>= 4; msb += 4; }
+    if( v >> 2 ){ v >>= 2; msb += 2; }
+    if( v >> 1 ){ msb += 1; }
+
+    int shift = msb - GPIB_HISTOGRAM_SUB_BITS;
+    return ( shift + 1 ) * GPIB_HISTOGRAM_SUB_BUCKETS + (int)( ( value >> shift ) - GPIB_HISTOGRAM_SUB_BUCKETS );
+}
+
+/**
+  * @brief Lowest value in us of a bucket.
+  */
+quint64 GPIBLatencyHistogram::bucketValue(int index)
+{
+    if( index < GPIB_HISTOGRAM_SUB_BUCKETS ) return index;
+
+    int shift = index / GPIB_HISTOGRAM_SUB_BUCKETS - 1;
+    int sub = index % GPIB_HISTOGRAM_SUB_BUCKETS;
+    return (quint64)( GPIB_HISTOGRAM_SUB_BUCKETS + sub ) << shift;
+}
+
+//
+// GPIBLatencyStats
+//
+
+/**
+  * Histogram of one operation written by a single thread. The counters are atomics
+  * only so snapshot can read them while they are written; the writer uses plain
+  * relaxed loads and stores.
+  */
+struct LatencySlot
+{
+    std::atomic<quint64> buckets[GPIB_HISTOGRAM_BUCKETS];
+    std::atomic<quint64> samples;
+    std::atomic<quint64> total;
+    std::atomic<quint64> bytes;
+    std::atomic<quint64> minimum;
+    std::atomic<quint64> maximum;
+
+    LatencySlot()
+    {
+        for( int i = 0; i < GPIB_HISTOGRAM_BUCKETS; i++ ) buckets[i].store( 0, std::memory_order_relaxed );
+        samples.store( 0, std::memory_order_relaxed );
+        total.store( 0, std::memory_order_relaxed );
+        bytes.store( 0, std::memory_order_relaxed );
+        minimum.store( 0, std::memory_order_relaxed );
+        maximum.store( 0, std::memory_order_relaxed );
+    }
+};
+
+/**
+  * Histograms of one thread. The slots are created on first use. When the thread
+  * ends the recorder is handed to the next new thread, keeping its samples.
+  */
+struct LatencyRecorder
+{
+    std::atomic<LatencySlot *> histograms[GPIB_LATENCY_ADDRESSES][GPIB_OP_COUNT];
+    std::atomic<bool> inUse;
+
+    LatencyRecorder()
+    {
+        for( int a = 0; a < GPIB_LATENCY_ADDRESSES; a++ )
+            for( int o = 0; o < GPIB_OP_COUNT; o++ ) histograms[a][o].store( 0, std::memory_order_relaxed );
+        inUse.store( true );
+    }
+};
+
+/**
+  * Recorders of all the threads. Built on first use, so ports can be used from
+  * static constructors.
+  */
+struct LatencyRegistry
+{
+    QMutex mutex;
+    QList<LatencyRecorder *> recorders;
+};
+
+static LatencyRegistry *registry()
+{
+    static LatencyRegistry instance;
+    return &instance;
+}
+
+static std::atomic<bool> enabled( true );
+
+struct RecorderOwner
+{
+    LatencyRecorder *recorder = 0;
+
+    ~RecorderOwner()
+    {
+        if( recorder ) recorder->inUse.store( false );
+    }
+};
+
+static thread_local RecorderOwner owner;
+
+static LatencyRecorder *threadRecorder()
+{
+    if( owner.recorder ) return owner.recorder;
+
+    LatencyRegistry *threads = registry();
+    QMutexLocker locker(&threads->mutex);
+    for( int i = 0; i < threads->recorders.size() && !owner.recorder; i++ ){
+        bool free = false;
+        if( threads->recorders.at(i)->inUse.compare_exchange_strong( free, true ) ) owner.recorder = threads->recorders.at(i);
+    }
+    if( !owner.recorder ){
+        owner.recorder = new LatencyRecorder;
+        threads->recorders.append( owner.recorder );
+    }
+    return owner.recorder;
+}
+
+static inline void increment(std::atomic<quint64> &counter, quint64 value)
+{
+    counter.store( counter.load( std::memory_order_relaxed ) + value, std::memory_order_relaxed );
+}
+
+/**
+  * @brief Record the latency of one operation on the calling thread.
+  *
+  * @param address The primary address of the device.
+  * @param operation A GPIBOperation.
+  * @param nanoseconds The time taken, from a monotonic clock.
+  * @param bytes Bytes transferred, from ibcnt.
+  */
+void GPIBLatencyStats::record(int address, int operation, qint64 nanoseconds, long bytes)
+{
+    if( !enabled.load( std::memory_order_relaxed ) ) return;
+    if( operation < 0 || operation >= GPIB_OP_COUNT ) return;
+    if( address < 0 || address >= GPIB_LATENCY_ADDRESSES ) address = GPIB_LATENCY_ADDRESSES - 1;
+
+    LatencyRecorder *recorder = threadRecorder();
+    LatencySlot *slot = recorder->histograms[address][operation].load( std::memory_order_relaxed );
+    if( !slot ){
+        slot = new LatencySlot;
+        recorder->histograms[address][operation].store( slot, std::memory_order_release );
+    }
+
+    quint64 value = nanoseconds > 0 ? (quint64)nanoseconds / 1000 : 0;
+    quint64 samples = slot->samples.load( std::memory_order_relaxed );
+    increment( slot->buckets[ GPIBLatencyHistogram::bucketIndex( value ) ], 1 );
+    increment( slot->total, value );
+    if( bytes > 0 ) increment( slot->bytes, bytes );
+    if( samples == 0 || value < slot->minimum.load( std::memory_order_relaxed ) )
+        slot->minimum.store( value, std::memory_order_relaxed );
+    if( value > slot->maximum.load( std::memory_order_relaxed ) )
+        slot->maximum.store( value, std::memory_order_relaxed );
+    slot->samples.store( samples + 1, std::memory_order_release );
+}
+
+/**
+  * @brief Merge the histograms of all the threads for an operation.
+  *
+  * The threads go on recording while it runs, so the samples of the operations in
+  * flight may be partly included.
+  *
+  * @param address The primary address of the device, or -1 for all the devices.
+  * @param operation A GPIBOperation.
+  * @param result Set to the merged histogram.
+  * @return false if there are no samples.
+  */
+bool GPIBLatencyStats::snapshot(int address, int operation, GPIBLatencyHistogram &result)
+{
+    result.clear();
+    if( operation < 0 || operation >= GPIB_OP_COUNT ) return false;
+
+    int first = address, last = address;
+    if( address < 0 ){
+        first = 0;
+        last = GPIB_LATENCY_ADDRESSES - 1;
+    } else if( address >= GPIB_LATENCY_ADDRESSES ){
+        first = last = GPIB_LATENCY_ADDRESSES - 1;
+    }
+
+    GPIBLatencyHistogram part;
+    LatencyRegistry *threads = registry();
+    QMutexLocker locker(&threads->mutex);
+    for( int r = 0; r < threads->recorders.size(); r++ ){
+        for( int a = first; a <= last; a++ ){
+            LatencySlot *slot = threads->recorders.at(r)->histograms[a][operation].load( std::memory_order_acquire );
+            if( !slot ) continue;
+
+            part.samples = slot->samples.load( std::memory_order_acquire );
+            if( part.samples == 0 ) continue;
+            for( int i = 0; i < GPIB_HISTOGRAM_BUCKETS; i++ )
+                part.buckets[i] = slot->buckets[i].load( std::memory_order_relaxed );
+            part.total = slot->total.load( std::memory_order_relaxed );
+            part.byteCount = slot->bytes.load( std::memory_order_relaxed );
+            part.minimum = slot->minimum.load( std::memory_order_relaxed );
+            part.maximum = slot->maximum.load( std::memory_order_relaxed );
+            result.add( part );
+        }
+    }
+    return result.count() > 0;
+}
+
+/**
+  * @brief Turn the recording on or off. It is on by default.
+  */
+void GPIBLatencyStats::setEnabled(bool state) {enabled.store( state );}
+
+bool GPIBLatencyStats::isEnabled() {return enabled.load( std::memory_order_relaxed );}
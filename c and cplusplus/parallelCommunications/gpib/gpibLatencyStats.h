@@ -0,0 +1,121 @@
+#ifndef GPIBLATENCYSTATS_H
+#define GPIBLATENCYSTATS_H
+
+#include <QElapsedTimer>
+#include <QVector>
+#include <QtGlobal>
+
+/**
+  * Operations timed by GPIBPort
+  *  - WRITE = one ibwrt
+  *  - READ = one ibrd (a chunk of readAll and readStream)
+  *  - SRQ_WAIT = waitForServiceRequest, the time the instrument takes
+  *  - READ_QUERY = a whole :READ? transaction (write, SRQ wait and read)
+  *  - STATUS_QUERY = stbQuery, esrQuery and the other register queries
+  */
+enum GPIBOperation
+{
+    GPIB_OP_WRITE = 0,
+    GPIB_OP_READ,
+    GPIB_OP_SRQ_WAIT,
+    GPIB_OP_READ_QUERY,
+    GPIB_OP_STATUS_QUERY,
+    GPIB_OP_COUNT
+};
+
+/**
+  * Histogram layout, as HDR histograms: values below 2^GPIB_HISTOGRAM_SUB_BITS us
+  * have a bucket each, above that every power of two is split in
+  * 2^GPIB_HISTOGRAM_SUB_BITS buckets (6% resolution). Values are clamped to
+  * 2^GPIB_HISTOGRAM_MAX_BITS us (about 12 days).
+  */
+#define GPIB_HISTOGRAM_SUB_BITS 4
+#define GPIB_HISTOGRAM_SUB_BUCKETS ( 1 << GPIB_HISTOGRAM_SUB_BITS )
+#define GPIB_HISTOGRAM_MAX_BITS 40
+#define GPIB_HISTOGRAM_BUCKETS ( ( GPIB_HISTOGRAM_MAX_BITS - GPIB_HISTOGRAM_SUB_BITS + 1 ) * GPIB_HISTOGRAM_SUB_BUCKETS )
+
+/**
+  * GPIB primary addresses are 0 to 30, the last slot collects any other value
+  */
+#define GPIB_LATENCY_ADDRESSES 32
+
+/**
+  * @brief Latency distribution of one operation, a snapshot of GPIBLatencyStats.
+  *
+  * Latencies are in microseconds.
+  */
+class GPIBLatencyHistogram
+{
+public:
+    GPIBLatencyHistogram();
+
+    void    clear();
+    void    add( const GPIBLatencyHistogram &other );
+
+    quint64 count() const;
+    quint64 bytes() const;
+    quint64 min() const;
+    quint64 max() const;
+    double  mean() const;
+    quint64 valueAtPercentile( double percentile ) const;
+    quint64 bucketCount( int index ) const;
+
+    static int     bucketIndex( quint64 value );
+    static quint64 bucketValue( int index );
+
+private:
+    friend class GPIBLatencyStats;
+
+    QVector<quint64> buckets;
+    quint64 samples;
+    quint64 total;
+    quint64 byteCount;
+    quint64 minimum;
+    quint64 maximum;
+};
+
+/**
+  * @brief Process wide latency histograms of the GPIBPort operations, by device address.
+  *
+  * Every thread records into histograms of its own, without locks or atomic
+  * read-modify-write, so recording costs a few hundred ns and can be left on.
+  * snapshot merges the histograms of all the threads.
+  */
+class GPIBLatencyStats
+{
+public:
+    static void record( int address, int operation, qint64 nanoseconds, long bytes );
+    static bool snapshot( int address, int operation, GPIBLatencyHistogram &result );
+
+    static void setEnabled( bool state );
+    static bool isEnabled();
+};
+
+/**
+  * @brief Times an operation for the lifetime of the object.
+  */
+class GPIBLatencyProbe
+{
+public:
+    GPIBLatencyProbe(int address, int operation)
+    {
+        this->address = address;
+        this->operation = operation;
+        bytes = 0;
+        if( GPIBLatencyStats::isEnabled() ) timer.start();
+    }
+    ~GPIBLatencyProbe()
+    {
+        if( timer.isValid() ) GPIBLatencyStats::record( address, operation, timer.nsecsElapsed(), bytes );
+    }
+
+    void setBytes(long count) {bytes = count;}
+
+private:
+    QElapsedTimer timer;
+    int  address;
+    int  operation;
+    long bytes;
+};
+
+#endif // GPIBLATENCYSTATS_H
@@ -0,0 +1,232 @@
+#include "./gpib/parallelCommunications/gpib/gpibNativeDriver.h"
+
+#ifndef TEST
+
+#ifdef AD_GPIB
+    #include <mutex>
+
+    // ADLINK keeps iberr and ibcntl only in process globals: a call and the capture of
+    // its status must not be interleaved with the calls of other threads
+    static std::recursive_mutex statusMutex;
+    #define STATUS_LOCK std::lock_guard<std::recursive_mutex> statusLocker( statusMutex )
+#else
+    #define STATUS_LOCK
+#endif
+
+GPIBNativeDriver::GPIBNativeDriver()
+{
+}
+
+GPIBNativeDriver::~GPIBNativeDriver()
+{
+#ifdef LINUX_GPIB
+    std::map<int, std::thread> pending;
+    {
+        std::lock_guard<std::mutex> locker( waitersMutex );
+        pending.swap( waiters );
+    }
+    for( std::map<int, std::thread>::iterator i = pending.begin(); i != pending.end(); ++i ){
+        ibstop( i->first );
+        finishWaiter( i->second );
+    }
+#endif
+}
+
+/**
+  * @brief Status of the driver call that returned state.
+  *
+  * NI-488.2 and linux-gpib keep a copy per thread. ADLINK only has process globals,
+  * so its calls and this capture are made under STATUS_LOCK.
+  *
+  * @param state The value returned by the call, its ibsta.
+  */
+GPIBStatus GPIBNativeDriver::capture(int state)
+{
+    GPIBStatus status;
+#if defined(NI_PCI_GPIB) || defined(LINUX_GPIB)
+    (void)state;
+    status.ibsta = ThreadIbsta();
+    status.iberr = ThreadIberr();
+    status.ibcnt = ThreadIbcntl();
+#else
+    status.ibsta = state;
+    status.iberr = iberr;
+    status.ibcnt = ibcntl;
+#endif
+    return status;
+}
+
+GPIBStatus GPIBNativeDriver::ask(int ud, int option, int *value)
+{
+    STATUS_LOCK;
+    return capture( ibask( ud, option, value ) );
+}
+
+GPIBStatus GPIBNativeDriver::config(int ud, int option, int value)
+{
+    STATUS_LOCK;
+    return capture( ibconfig( ud, option, value ) );
+}
+
+GPIBStatus GPIBNativeDriver::openDevice(int boardIndex, int pad, int sad, int timo, int eot, int eos, int &ud)
+{
+    STATUS_LOCK;
+    ud = ibdev( boardIndex, pad, sad, timo, eot, eos );
+    return capture( ibsta );
+}
+
+GPIBStatus GPIBNativeDriver::online(int ud, int value)
+{
+    STATUS_LOCK;
+    return capture( ibonl( ud, value ) );
+}
+
+GPIBStatus GPIBNativeDriver::clear(int ud)
+{
+    STATUS_LOCK;
+    return capture( ibclr( ud ) );
+}
+
+GPIBStatus GPIBNativeDriver::goToLocal(int ud)
+{
+    STATUS_LOCK;
+    return capture( ibloc( ud ) );
+}
+
+GPIBStatus GPIBNativeDriver::findListener(int ud, int pad, int sad, short *listen)
+{
+    STATUS_LOCK;
+    return capture( ibln( ud, pad, sad, listen ) );
+}
+
+GPIBStatus GPIBNativeDriver::setPrimaryAddress(int ud, int pad)
+{
+    STATUS_LOCK;
+    return capture( ibpad( ud, pad ) );
+}
+
+GPIBStatus GPIBNativeDriver::setSecondaryAddress(int ud, int sad)
+{
+    STATUS_LOCK;
+    return capture( ibsad( ud, sad ) );
+}
+
+GPIBStatus GPIBNativeDriver::interfaceClear(int ud)
+{
+    STATUS_LOCK;
+    return capture( ibsic( ud ) );
+}
+
+GPIBStatus GPIBNativeDriver::remoteEnable(int ud, int value)
+{
+    STATUS_LOCK;
+    return capture( ibsre( ud, value ) );
+}
+
+GPIBStatus GPIBNativeDriver::setTimeout(int ud, int timo)
+{
+    STATUS_LOCK;
+    return capture( ibtmo( ud, timo ) );
+}
+
+GPIBStatus GPIBNativeDriver::write(int ud, const char *data, long count)
+{
+    STATUS_LOCK;
+    // ibwrt of ni488.h takes a non const buffer, it is not modified
+    return capture( ibwrt( ud, const_cast<char *>(data), count ) );
+}
+
+GPIBStatus GPIBNativeDriver::read(int ud, char *buffer, long count)
+{
+    STATUS_LOCK;
+    return capture( ibrd( ud, buffer, count ) );
+}
+
+GPIBStatus GPIBNativeDriver::wait(int ud, int mask)
+{
+    STATUS_LOCK;
+    return capture( ibwait( ud, mask ) );
+}
+
+GPIBStatus GPIBNativeDriver::serialPoll(int ud, char *spr)
+{
+    STATUS_LOCK;
+    return capture( ibrsp( ud, spr ) );
+}
+
+GPIBStatus GPIBNativeDriver::writeAsync(int ud, const char *data, long count)
+{
+    STATUS_LOCK;
+    return capture( ibwrta( ud, const_cast<char *>(data), count ) );
+}
+
+GPIBStatus GPIBNativeDriver::readAsync(int ud, char *buffer, long count)
+{
+    STATUS_LOCK;
+    return capture( ibrda( ud, buffer, count ) );
+}
+
+GPIBStatus GPIBNativeDriver::notify(int ud, int mask, GpibNotifyReceiver *receiver)
+{
+#ifdef LINUX_GPIB
+    // linux-gpib has no ibnotify: wait for the mask in a thread of our own. The
+    // thread is kept so stop can join it; the one of the previous transfer of the
+    // descriptor has already notified it
+    std::lock_guard<std::mutex> locker( waitersMutex );
+    finishWaiter( waiters[ud] );
+    waiters[ud] = std::thread( [ud, mask, receiver]() {
+        GPIBStatus status = capture( ibwait( ud, mask ) );
+        receiver->gpibNotify( ud, status.ibsta, status.iberr, status.ibcnt );
+    } );
+
+    GPIBStatus status;
+    status.ibsta = CMPL;
+    return status;
+#else
+    STATUS_LOCK;
+    return capture( ibnotify( ud, mask, notifyReceiverCallback, receiver ) );
+#endif
+}
+
+/**
+  * @brief Abort the asynchronous transfer of a descriptor.
+  *
+  * With linux-gpib it also waits for the notification thread, so the receiver given
+  * to notify is not called once this returns.
+  */
+GPIBStatus GPIBNativeDriver::stop(int ud)
+{
+    GPIBStatus status;
+    {
+        STATUS_LOCK;
+        status = capture( ibstop( ud ) );
+    }
+#ifdef LINUX_GPIB
+    std::thread waiter;
+    {
+        std::lock_guard<std::mutex> locker( waitersMutex );
+        std::map<int, std::thread>::iterator i = waiters.find( ud );
+        if( i != waiters.end() ){
+            waiter.swap( i->second );
+            waiters.erase( i );
+        }
+    }
+    finishWaiter( waiter );
+#endif
+    return status;
+}
+
+#ifdef LINUX_GPIB
+/**
+  * @brief Join a notification thread, or let it end on its own when it is the caller
+  * (a completion that starts the next transfer).
+  */
+void GPIBNativeDriver::finishWaiter(std::thread &waiter)
+{
+    if( !waiter.joinable() ) return;
+    if( waiter.get_id() == std::this_thread::get_id() ) waiter.detach();
+    else waiter.join();
+}
+#endif
+
+#endif
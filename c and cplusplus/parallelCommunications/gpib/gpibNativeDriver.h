@@ -0,0 +1,62 @@
+#ifndef GPIBNATIVEDRIVER_H
+#define GPIBNATIVEDRIVER_H
+
+#include "./gpib/parallelCommunications/gpib/gpibDriver.h"
+
+#ifndef TEST
+
+#ifdef LINUX_GPIB
+    #include <map>
+    #include <mutex>
+    #include <thread>
+#endif
+
+/**
+  * @brief Backend that calls the driver of the board (NI-488.2, ADLINK or linux-gpib).
+  *
+  * With NI-488.2 and linux-gpib the status is taken from ThreadIbsta, ThreadIberr
+  * and ThreadIbcntl, so it belongs to the calling thread. ADLINK has no per thread
+  * status: every call is made under a process lock, together with the read of the
+  * globals, so the threads take turns on the driver.
+  */
+class GPIBNativeDriver: public GPIBDriver
+{
+public:
+    GPIBNativeDriver();
+    ~GPIBNativeDriver();
+
+    GPIBStatus ask( int ud, int option, int *value );
+    GPIBStatus config( int ud, int option, int value );
+    GPIBStatus openDevice( int boardIndex, int pad, int sad, int timo, int eot, int eos, int &ud );
+    GPIBStatus online( int ud, int value );
+    GPIBStatus clear( int ud );
+    GPIBStatus goToLocal( int ud );
+    GPIBStatus findListener( int ud, int pad, int sad, short *listen );
+    GPIBStatus setPrimaryAddress( int ud, int pad );
+    GPIBStatus setSecondaryAddress( int ud, int sad );
+    GPIBStatus interfaceClear( int ud );
+    GPIBStatus remoteEnable( int ud, int value );
+    GPIBStatus setTimeout( int ud, int timo );
+    GPIBStatus write( int ud, const char *data, long count );
+    GPIBStatus read( int ud, char *buffer, long count );
+    GPIBStatus wait( int ud, int mask );
+    GPIBStatus serialPoll( int ud, char *spr );
+    GPIBStatus writeAsync( int ud, const char *data, long count );
+    GPIBStatus readAsync( int ud, char *buffer, long count );
+    GPIBStatus notify( int ud, int mask, GpibNotifyReceiver *receiver );
+    GPIBStatus stop( int ud );
+
+private:
+    static GPIBStatus capture( int state );
+
+#ifdef LINUX_GPIB
+    static void finishWaiter( std::thread &waiter );
+
+    std::mutex                 waitersMutex;
+    std::map<int, std::thread> waiters;
+#endif
+};
+
+#endif
+
+#endif // GPIBNATIVEDRIVER_H
@@ -1,39 +1,192 @@
 #include "./gpib/parallelCommunications/gpib/gpibPort.h"
+#include "./gpib/parallelCommunications/gpib/gpibQueryPipeline.h"
+
+// Status of the last driver call made by a GPIBPort on each thread, for callStatus()
+thread_local GPIBStatus GPIBPort::threadStatus;
 
 GPIBPort::GPIBPort(int addr):ParallelPort()
 {
-    #if DEBUG_GPIBPORT==1
-        qDebug()<<"GPIB-PORT:GPIBPort("+QString::number(addr)+"): Constructing an instance of GPIBPort class. ";
-    #endif
     setAddress(addr);
 }
 GPIBPort::GPIBPort():ParallelPort()
 {
     int add = 24;
-    #if DEBUG_GPIBPORT==1
-        qDebug()<<"GPIB-PORT:GPIBPort("+QString::number(add)+"): Constructing an instance by defalult of GPIBPort class. ";
-    #endif
     setAddress(add);
 }
-GPIBPort::~GPIBPort(){}
+GPIBPort::~GPIBPort()
+{
+    // The driver must not notify a destroyed port
+    if( isAsyncPending() ){
+        long count;
+        abortAsync();
+        waitAsync( count );
+    }
+    if( device >= 0 ) GPIBDescriptorPool::instance()->release( driver, device );
+}
 
 
 void GPIBPort::setAddress(int addr)
 {
-    #if DEBUG_GPIBPORT==1
-        qDebug()<<"GPIB-PORT("+QString::number(this->getAddress())+"):void setAddress("+QString::number(addr)+"): Setting the address of the GPIB Port. ";
-    #endif
     if (addr<=0 || addr>31) address = 24;
     address = addr;
 }
 
 int GPIBPort::getAddress(){return address;}
+
+/**
+  * @brief Set the priority class of the transactions of this port on the shared bus.
+  *
+  * @param priority BUS_PRIORITY_CRITICAL, BUS_PRIORITY_NORMAL or BUS_PRIORITY_BULK.
+  */
+void GPIBPort::setBusPriority(int priority){busPriority = priority;}
+int GPIBPort::getBusPriority(){return busPriority;}
+/**
+  * @brief Set the I/O timeout of the device.
+  *
+  * The timeout is set on the device descriptor, not on the board, so other devices
+  * of the same board keep theirs. It is kept if the connection is not open yet.
+  *
+  * @param timo One of the TIMEOUT_* values.
+  */
 int GPIBPort::setTimeout (int timo)
 {
-    #if DEBUG_GPIBPORT==1
-        qDebug()<<"GPIB-PORT("+QString::number(this->getAddress())+"):int setTimeout ("+QString::number(timo)+"): Setting the timeout of the GPIB Card. ";
-    #endif
-    return ibtmo(BOARD_INDEX,timo);
+    timeout = timo;
+    if( device >= 0 ){
+        capture( GPIBDescriptorPool::instance()->setTimeout( driver, device, timo ) );
+        GPIBTrace::event( address, GPIB_TRACE_TIMEOUT, lastStatus.ibsta, timo );
+        return checkCall();
+    }
+    return EXIT_SUCCESS;
+}
+
+int GPIBPort::getTimeout(){return timeout;}
+
+/**
+  * @brief Expected time to take the readings of one trigger of the instrument.
+  *
+  * Computed from the settings of the instrument: trigger count x filter count x
+  * NPLC, plus the source and trigger delays. They are taken from the state cache,
+  * which sees every write; the ones it does not hold are asked to the instrument
+  * and cached, so call it while the instrument is idle.
+  *
+  * @return The time in ms, or -1 if a setting is not known.
+  */
+long GPIBPort::expectedMeasurementTime()
+{
+    QString value;
+    bool ok = false;
+    if( !knownSetting("TRIG:COUN", value) ) return -1;
+    long triggerCount = value.toInt(&ok);
+    if( !ok || triggerCount <= 0 ) return -1;
+
+    // The factory sets the speed through VOLT:NPLC, but any function may have been set
+    static const char *nplcHeaders[] = { "SENS:VOLT:NPLC", "SENS:CURR:NPLC", "SENS:RES:NPLC" };
+    double nplc = -1;
+    for( int i = 0; i < 3; i++ ){
+        if( !stateCache.contains( nplcHeaders[i] ) ) continue;
+        double cached = stateCache.value( nplcHeaders[i] ).toDouble(&ok);
+        if( !ok ) return -1;
+        nplc = qMax( nplc, cached );
+    }
+    if( nplc < 0 ){
+        // One speed for all the functions
+        if( !knownSetting("SENS:VOLT:NPLC", value) ) return -1;
+        nplc = value.toDouble(&ok);
+        if( !ok ) return -1;
+    }
+
+    long filterCount = 1;
+    if( !knownSetting("SENS:AVER:STAT", value) ) return -1;
+    if( value.toUpper() == "ON" || value == "1" ){
+        if( !knownSetting("SENS:AVER:COUN", value) ) return -1;
+        filterCount = value.toInt(&ok);
+        if( !ok ) return -1;
+        if( filterCount < 1 ) filterCount = 1;
+    }
+
+    double delay = 0;
+    static const char *delayHeaders[] = { "SOUR:DEL", "TRIG:DEL" };
+    for( int i = 0; i < 2; i++ ){
+        if( !knownSetting( delayHeaders[i], value ) ) return -1;
+        double seconds = value.toDouble(&ok);
+        if( !ok ) return -1;
+        if( seconds > 0 ) delay += seconds * 1000;
+    }
+
+    double reading = nplc * LINE_CYCLE_MS * CONVERSIONS_PER_READING * filterCount
+            + READING_OVERHEAD_MS + delay;
+    return (long)( triggerCount * reading );
+}
+
+/**
+  * @brief Value of a setting of the instrument.
+  *
+  * Taken from the state cache or, if it is not there, queried and then cached.
+  *
+  * @param header Short form header without the leading ":", e.g. "TRIG:COUN".
+  * @param value Set to the value, as sent or as answered by the instrument.
+  * @return false if the value is not cached and the query fails.
+  */
+bool GPIBPort::knownSetting(const QString &header, QString &value)
+{
+    if( stateCache.contains(header) ){
+        value = stateCache.value(header);
+        return true;
+    }
+    if( !isNoError() ) return false;
+
+    QByteArray response;
+    if( write( QString(":") + header + "?" ) != EXIT_SUCCESS ) return false;
+    if( readAll( response ) != EXIT_SUCCESS ) return false;
+
+    value = QString::fromLatin1( response.constData(), response.size() ).trimmed();
+    if( value.isEmpty() ) return false;
+    stateCache.update( QString(":") + header + " " + value );
+    return true;
+}
+
+/**
+  * @brief Timeout for an operation that waits for the readings of one trigger.
+  *
+  * Meant to be applied with GPIBTimeoutGuard around :READ?, :INIT and the wait for
+  * the end of a sweep. When the measurement time is not known a long timeout is
+  * used, so a legitimate long sweep is never cut off.
+  */
+int GPIBPort::measurementTimeout()
+{
+    long expected = expectedMeasurementTime();
+    if( expected < 0 ) return timeoutFor( 100000 );
+    return timeoutFor( TIMEOUT_BASE_MS + TIMEOUT_MARGIN * expected );
+}
+
+/**
+  * @brief Smallest timeout of the driver table that is not shorter than a time.
+  *
+  * @param milliseconds The time to wait.
+  */
+int GPIBPort::timeoutFor(long milliseconds)
+{
+    if( milliseconds <= 1000 ) return TIMEOUT_1s;
+    if( milliseconds <= 3000 ) return TIMEOUT_3s;
+    if( milliseconds <= 10000 ) return TIMEOUT_10s;
+    if( milliseconds <= 30000 ) return TIMEOUT_30s;
+    if( milliseconds <= 100000 ) return TIMEOUT_100s;
+    if( milliseconds <= 300000 ) return TIMEOUT_300s;
+    return TIMEOUT_1000s;
+}
+
+/**
+  * @brief Time of a timeout of the driver table, from T10us to T1000s.
+  *
+  * @param timo The timeout code.
+  * @return The time in ms, rounded up, or -1 for TNONE (no timeout).
+  */
+long GPIBPort::timeoutMilliseconds(int timo)
+{
+    static const long milliseconds[] = { -1, 1, 1, 1, 1, 1, 3, 10, 30, 100, 300,
+                                         1000, 3000, 10000, 30000, 100000, 300000, 1000000 };
+    if( timo <= TNONE || timo > T1000s ) return -1;
+    return milliseconds[timo];
 }
 
 /**
@@ -49,50 +202,115 @@ int GPIBPort::testInstrunction(QString instruction)
 
 /**
   * @brief Use to read Status and Standard registers and masks (enable)
+  *
+  * The four queries go in one program message (see GPIBQueryPipeline).
   */
 int GPIBPort::allResgistersQueryTest()
 {
-    int result = 0;
-    // Status byte register
-    // Event
-    //QTest::qSleep(1000);
-
-    int statusR = stbQuery();
+    GPIBQueryPipeline pipeline( this );
+    // Status byte register: event and enable
+    std::future<QByteArray> statusEvent = pipeline.enqueue( "*STB?" );
+    std::future<QByteArray> statusEnable = pipeline.enqueue( "*SRE?" );
+    // Standard register: event and enable
+    std::future<QByteArray> standardEvent = pipeline.enqueue( "*ESR?" );
+    std::future<QByteArray> standardEnable = pipeline.enqueue( "*ESE?" );
+    int result = pipeline.flush();
+
+    int statusR = statusEvent.get().toInt();
     statusR = statusR +1 -1;
-
-    // Enable
-    //QTest::qSleep(1000);
-
-    QString statusE = sreQuery();
-    statusE = statusE.append("!!");
-
-    // Standard register
-    // Event
-    //QTest::qSleep(1000);
-    QString standardR = esrQuery().toString();
-    standardR = standardR.append("!!");
-
-    // Enable
-    QString standardE = eseQuery().toString();
-    statusE = standardE.append("!!");
+    QString statusE = QString( statusEnable.get() ).append("!!");
+    QString standardR = QString( standardEvent.get() ).append("!!");
+    QString standardE = QString( standardEnable.get() ).append("!!");
 
     return result;
 }
 
+/**
+  * @brief Read and reset the Standard Event, Operation, Measurement and Questionable
+  * event registers with one write and one read.
+  *
+  * @return EXIT_SUCCESS or a GPIB error status, in which case the registers are 0.
+  */
+int GPIBPort::eventRegistersQuery(int &esr, int &oer, int &mer, int &qer)
+{
+    GPIBQueryPipeline pipeline( this );
+    std::future<QByteArray> standard = pipeline.enqueue( "*ESR?" );
+    std::future<QByteArray> operation = pipeline.enqueue( ":STAT:OPER:EVEN?" );
+    std::future<QByteArray> measurement = pipeline.enqueue( ":STAT:MEAS:EVEN?" );
+    std::future<QByteArray> questionable = pipeline.enqueue( ":STAT:QUES:EVEN?" );
+    int status = pipeline.flush();
+
+    esr = standard.get().toInt();
+    oer = operation.get().toInt();
+    mer = measurement.get().toInt();
+    qer = questionable.get().toInt();
+    return status;
+}
+
 
 int GPIBPort::sendReadQueryAndGetResultAsCharArray( char* message, const int bytesToRead )
 {
-    QString output = QString( ":READ?" );
-    //qDebug() << output.toLocal8Bit().data();
-
-    if( isNoError() ) {
-        qDebug() << "NO GPIB ERROR";
-        write( output.toLocal8Bit().data() );
-        QThread::msleep(10);
+    int status;
+    int attempt = 0;
+    GPIBLatencyProbe probe( address, GPIB_OP_READ_QUERY );
+    GPIBTimeoutGuard measurement( this, measurementTimeout() );
+    do {
+        transactionDepth++;
+        status = write( READ_QUERY, READ_QUERY_LENGTH );
+        if( status == EXIT_SUCCESS ) status = waitForMessageAvailable();
+        if( status == EXIT_SUCCESS ) status = read( message, bytesToRead );
+        transactionDepth--;
+    } while( status != EXIT_SUCCESS && retryAfterError( attempt++ ) );
+
+    // NUL terminated in place of the terminator, when there is room
+    if( status == EXIT_SUCCESS ){
+        long length = stripTerminator( message, lastStatus.ibcnt );
+        if( length < bytesToRead ) message[length] = '\0';
+        probe.setBytes( length );
     }
-    else qDebug() << "GPIB ERROR";
+    return status;
+}
 
-    return read( message, bytesToRead );
+/**
+  * @brief Trigger a reading and read it into a caller buffer.
+  *
+  * Allocation free version of sendReadQueryAndGetResultAsString, meant for tight
+  * acquisition loops.
+  *
+  * @param buffer Is the storage buffer for the read data.
+  * @param capacity An integer that specifies the size of buffer.
+  * @param count Set to the number of bytes read, taken from ibcnt.
+  */
+int GPIBPort::sendReadQueryAndReadInto( char *buffer, int capacity, int &count )
+{
+    int status;
+    int attempt = 0;
+    GPIBLatencyProbe probe( address, GPIB_OP_READ_QUERY );
+    GPIBTimeoutGuard measurement( this, measurementTimeout() );
+    do {
+        transactionDepth++;
+        count = 0;
+        status = write( READ_QUERY, READ_QUERY_LENGTH );
+        if( status == EXIT_SUCCESS ) status = waitForMessageAvailable();
+        if( status == EXIT_SUCCESS ) status = readInto( buffer, capacity, count );
+        transactionDepth--;
+    } while( status != EXIT_SUCCESS && retryAfterError( attempt++ ) );
+
+    probe.setBytes( count );
+    return status;
+}
+
+/**
+  * @brief Trigger a reading and read it into a caller buffer.
+  *
+  * @param reading Set to the bytes read, a view of buffer without the terminator.
+  */
+int GPIBPort::sendReadQueryAndReadInto( char *buffer, int capacity, std::string_view &reading )
+{
+    int count = 0;
+    int status = sendReadQueryAndReadInto( buffer, capacity, count );
+    reading = std::string_view( buffer, count );
+    return status;
 }
 
 int GPIBPort:: sendReadQueryAndGetResultAsString(int size, QString &result)
@@ -100,31 +318,33 @@ int GPIBPort:: sendReadQueryAndGetResultAsString(int size, QString &result)
     int readSize = size;
     if (readSize< (READBUFFER_SIZE_MIN) || readSize>(READBUFFER_SIZE_MAX)) readSize = READBUFFER_SIZE_DEFAULT;
 
-    QString output = QString( ":READ?" );
-    //qDebug() << output.toLocal8Bit().data();
-
-    if( isNoError() ) {
-        //qDebug() << "NO GPIB ERROR";
-        write( output.toLocal8Bit().data() );
-        QThread::msleep(10);
-    }
-    //else qDebug() << "GPIB ERROR";
-
-
-    char measure[readSize + 50];
-    if( isNoError() ) read( measure, readSize);
-
-
-    result = QString(QVariant(measure).toString());
+    QByteArray measure;
+    int status;
+    int attempt = 0;
+    GPIBLatencyProbe probe( address, GPIB_OP_READ_QUERY );
+    GPIBTimeoutGuard measurement( this, measurementTimeout() );
+    do {
+        transactionDepth++;
+        measure.clear();
+        status = write( READ_QUERY, READ_QUERY_LENGTH );
+        if( status == EXIT_SUCCESS ) status = waitForMessageAvailable();
+        if( status == EXIT_SUCCESS ) status = readAll( measure, readSize );
+        transactionDepth--;
+    } while( status != EXIT_SUCCESS && retryAfterError( attempt++ ) );
+
+    result = QString::fromLocal8Bit( measure.constData(), measure.size() );
+    probe.setBytes( measure.size() );
 
-    return errors();
+    return status;
 }
 
 
 /**
   * @brief Read messages from GPIB bus.
   *
-  * @return A char[100] that contains 42 bytes read from the device.
+  * The whole response is read until END, size is only used as the chunk size.
+  *
+  * @return A QVariant that contains the bytes read from the device, without the terminator.
   */
 
 int GPIBPort:: read(int size, QVariant &result)
@@ -132,22 +352,11 @@ int GPIBPort:: read(int size, QVariant &result)
     int readSize = size;
     if (readSize< (READBUFFER_SIZE_MIN) || readSize>(READBUFFER_SIZE_MAX)) readSize = READBUFFER_SIZE_DEFAULT;
 
-
-#ifndef TEST
-    char measure[readSize + 50];
-    if( isNoError() ) read( measure, readSize);
-
-    /*for (int i=0;i<(readSize + 50);i++) {
-        qDebug() << measure[i];
-    }*/
+    QByteArray measure;
+    int status = isNoError() ? readAll( measure, readSize ) : errors();
 
     result = QVariant(measure);
-#else
-    result = QVariant("+9.979305E-01,+1.003080E-04,+1.074219E-02\n");
-    //return QVariant("UM, RANGE=12.000kV, VALUE=1.053kV");
-    //return QVariant("+5.000000E+00,+8.249011E-05,+5.285156E+02,+6.111000E+00,+8.381449E-05,+5.285205E+02,+7.222000E+00,+8.429056E-05,+5.285254E+02,+8.333500E+00,+8.415909E-05,+5.285303E+02,+9.444500E+00,+8.352670E-05,+5.285352E+02,+1.055550E+01,+8.389394E-05,+5.285400E+02,+1.166650E+01,+8.381329E-05,+5.285449E+02,+1.277800E+01,+8.840705E-05,+5.285498E+02,+1.388900E+01,+8.393636E-05,+5.285547E+02,+1.500000E+01,+8.438555E-05,+5.285596E+02\n\320\231\210\001\210a"" @0x1528be8");
-#endif
-    return errors();
+    return status;
 }
 
 /**
@@ -158,52 +367,347 @@ int GPIBPort:: read(int size, QVariant &result)
   */
 
 int GPIBPort::read(char* message, int size){
-#ifndef TEST
-    if( isNoError() ) ibrd (device, message, size);
-#endif
-    return errors();
+    GPIBBusLock bus( BOARD_INDEX, address, busPriority );
+    GPIBLatencyProbe probe( address, GPIB_OP_READ );
+    if( isNoError() ){
+        int count;
+        core.read( message, size, count );
+        capture( core.status() );
+        probe.setBytes( lastStatus.ibcnt );
+        GPIBTrace::transfer( address, GPIB_TRACE_READ, lastStatus.ibsta, message, lastStatus.ibcnt );
+    }
+    return checkCall();
 }
 
 
 /**
-  * @brief Open a device GPIB connection.
+  * @brief Read the device GPIB message into a caller buffer.
+  *
+  * @param buffer Is the storage buffer for the read data. It is not NUL terminated.
+  * @param capacity An integer that specifies the maximum number of bytes to read.
+  * @param count Set to the number of bytes read, taken from ibcnt. The terminator
+  * sent with END is not counted.
   */
 
-int GPIBPort::openConnection(int eos){
+int GPIBPort::readInto(char *buffer, int capacity, int &count)
+{
+    GPIBBusLock bus( BOARD_INDEX, address, busPriority );
+    GPIBLatencyProbe probe( address, GPIB_OP_READ );
+    count = 0;
+    if( isNoError() ){
+        core.read( buffer, capacity, count );
+        capture( core.status() );
+        probe.setBytes( lastStatus.ibcnt );
+        GPIBTrace::transfer( address, GPIB_TRACE_READ, lastStatus.ibsta, buffer, lastStatus.ibcnt );
+        count = lastStatus.isEnd() ? stripTerminator( buffer, lastStatus.ibcnt ) : lastStatus.ibcnt;
+    }
+    return checkCall();
+}
+
+/**
+  * @brief Read the device GPIB message into a caller buffer.
+  *
+  * @param response Set to the bytes read, a view of buffer without the terminator.
+  */
+
+int GPIBPort::readInto(char *buffer, int capacity, std::string_view &response)
+{
+    int count = 0;
+    int status = readInto( buffer, capacity, count );
+    response = std::string_view( buffer, count );
+    return status;
+}
+
+/**
+  * @brief Read a whole response, whatever its length.
+  *
+  * ibrd is repeated until the device asserts END, appending every chunk to result.
+  * The size of result is the exact number of bytes received, from ibcnt.
+  *
+  * @param result Is the storage for the read data. It grows as needed.
+  * @param chunkSize An integer that specifies the number of bytes requested on every ibrd.
+  * @param keepTerminator False to drop the "\n" sent with END, true for binary data.
+  */
+
+int GPIBPort::readAll(QByteArray &result, int chunkSize, bool keepTerminator)
+{
+    GPIBBusLock bus( BOARD_INDEX, address, busPriority );
     int status = EXIT_SUCCESS;
+    result.clear();
 
-    #if DEBUG_GPIBPORT==1
-        qDebug()<<"GPIB-PORT("+QString::number(this->getAddress())+"):int openConnection("+QString::number(eos)+"): Starting the opening the connection process.";
-    #endif
+    if( chunkSize <= 0 ) chunkSize = READ_CHUNK_SIZE;
 
-#ifndef TEST
-    short listen;
+    int received = 0;
+    while( isNoError() ){
+        if( result.size() < received + chunkSize )
+            result.resize( qMax( 2 * result.size(), received + chunkSize ) );
 
-    if( isNoError() ){
-        int v;
-        std::cout<<"Looking for the GPIB Interface"<<std::endl;
-        #if DEBUG_GPIBPORT==1
-            qDebug()<<"GPIB-PORT("+QString::number(this->getAddress())+"):int openConnection("+QString::number(eos)+"): ibask("+QString::number(BOARD_INDEX)+",1,&v): Query the configuration of the GPIB Board ";
-        #endif
-
-        ibask(BOARD_INDEX,1,&v);
-        status = errors();
+        status = read( result.data() + received, chunkSize );
+        if( status != EXIT_SUCCESS ) break;
+
+        received += lastStatus.ibcnt;
+        if( lastStatus.isEnd() ){
+            if( !keepTerminator ) received = stripTerminator( result.constData(), received );
+            break;
+        }
+
+        GPIBBusScheduler::board(BOARD_INDEX)->yield( address, busPriority );
     }
-    if( isNoError() ){
-        #if DEBUG_GPIBPORT==1
-            qDebug()<<"GPIB-PORT("+QString::number(this->getAddress())+"):int openConnection("+QString::number(eos)+"): ibdev("+QString::number(BOARD_INDEX)+", "+QString::number(address)+", "+QString::number(SAD)+", "+QString::number(TIMEOUT_3s)+", "+QString::number(EOT)+", "+QString::number(eos)+"): Open a the GPIB Board ";
-        #endif
-        device = ibdev(BOARD_INDEX, address, SAD, NEVERTIMEOUT, EOT, eos);
-        status = errors();
+    result.resize( received );
+    return status;
+}
+
+/**
+  * @brief Read a whole response handing every chunk to a consumer.
+  *
+  * ibrd is repeated until the device asserts END. The chunks are read into a
+  * buffer owned by the port and reused across calls, so the consumer must copy
+  * whatever it wants to keep.
+  *
+  * @param consumer Called with the data and the byte count of every chunk.
+  * @param chunkSize An integer that specifies the number of bytes requested on every ibrd.
+  */
+
+int GPIBPort::readStream(const std::function<void (const char *, int)> &consumer, int chunkSize)
+{
+    GPIBBusLock bus( BOARD_INDEX, address, busPriority );
+    int status = EXIT_SUCCESS;
+
+    if( chunkSize <= 0 ) chunkSize = READ_CHUNK_SIZE;
+    if( chunkBuffer.size() < chunkSize ) chunkBuffer.resize( chunkSize );
+
+    while( isNoError() ){
+        status = read( chunkBuffer.data(), chunkSize );
+        if( status != EXIT_SUCCESS ) break;
+
+        int count = lastStatus.ibcnt;
+        bool end = lastStatus.isEnd();
+        if( count > 0 ) consumer( chunkBuffer.constData(), count );
+        if( end ) break;
+
+        GPIBBusScheduler::board(BOARD_INDEX)->yield( address, busPriority );
     }
-    if( isNoError() ){
-        #if DEBUG_GPIBPORT==1
-            qDebug()<<"GPIB-PORT("+QString::number(this->getAddress())+"):int openConnection(int eos): ibln( "+QString::number(BOARD_INDEX)+", "+QString::number(address)+", "+QString::number(SAD)+ ", &listen): Check if listener (Instrument. Not the GPIB Board) is present. ";
-        #endif
-        ibln( BOARD_INDEX, address, SAD, &listen);
-        status = errors();
+    return status;
+}
+
+/**
+  * @brief Read an IEEE 488.2 binary block sent after :FORM:DATA REAL,32 or REAL,64.
+  *
+  * Done by SCPIDevice::readBlock, which accepts the definite length "#<n><len>" and
+  * the indefinite "#0" headers and decodes the readings straight from the bus bytes.
+  * A response that is not a block is read to its end and dropped.
+  *
+  * @param values Is the storage for the decoded readings.
+  * @param format DATA_FORMAT_REAL32 or DATA_FORMAT_REAL64, as programmed with formatData().
+  * @param swapped True if the instrument was programmed with :FORM:BORD SWAP.
+  * @return EXIT_SUCCESS, a GPIB error status, or -1 if the response is not a binary block.
+  */
+
+int GPIBPort::readBinaryBlock(QVector<double> &values, const int format, const bool swapped)
+{
+    GPIBBusLock bus( BOARD_INDEX, address, busPriority );
+    GPIBLatencyProbe probe( address, GPIB_OP_READ );
+    values.clear();
+    if( !isNoError() ) return errors();
+
+    long received = 0;
+    int status = core.readBlock( values, format, swapped, [&]( const char *data, int count ){
+        received += count;
+        GPIBTrace::transfer( address, GPIB_TRACE_READ, core.status().ibsta, data, count );
+        GPIBBusScheduler::board(BOARD_INDEX)->yield( address, busPriority );
+    } );
+    probe.setBytes( received );
+    capture( core.status() );
+    // The read stops at the first failed call
+    int call = checkCall();
+    return ( call != EXIT_SUCCESS ) ? call : status;
+}
+
+/**
+  * @brief Start an asynchronous write with ibwrta.
+  *
+  * The data is copied, so the caller can reuse it as soon as this returns. Only one
+  * asynchronous transfer can be pending on a port.
+  *
+  * @param data The bytes of the GPIB instruction desired.
+  * @param length The number of bytes to send.
+  * @param completion Optional function called from the driver thread when the write ends.
+  */
+int GPIBPort::writeAsync(const char *data, int length, const AsyncCompletion &completion)
+{
+    int status = startAsync( completion );
+    if( status != EXIT_SUCCESS ) return status;
+
+    GPIBBusLock bus( BOARD_INDEX, address, busPriority );
+    // The write ends later, and may fail: the cache must not trust what it sets
+    stateCache.forget( QString::fromLatin1( data, length ) );
+    asyncWriteBuffer = QByteArray( data, length );
+    GPIBStatus started = driver->writeAsync( device, asyncWriteBuffer.constData(), length );
+    capture( started );
+    GPIBTrace::transfer( address, GPIB_TRACE_WRITE, lastStatus.ibsta, data, length );
+    status = checkCall();
+    return armAsync( started, status );
+}
+
+/**
+  * @brief Start an asynchronous read with ibrda.
+  *
+  * @param buffer Is the storage buffer for the read data. It must stay valid until the
+  * transfer ends (see waitAsync).
+  * @param capacity An integer that specifies the maximum number of bytes to read.
+  * @param completion Optional function called from the driver thread when the read ends.
+  */
+int GPIBPort::readAsync(char *buffer, int capacity, const AsyncCompletion &completion)
+{
+    int status = startAsync( completion );
+    if( status != EXIT_SUCCESS ) return status;
+
+    GPIBBusLock bus( BOARD_INDEX, address, busPriority );
+    GPIBStatus started = driver->readAsync( device, buffer, capacity );
+    capture( started );
+    status = checkCall();
+    return armAsync( started, status );
+}
+
+/**
+  * @brief Block until the pending asynchronous transfer ends.
+  *
+  * @param count Set to the number of bytes transferred.
+  * @return EXIT_SUCCESS, or -1 if the transfer ended with an error.
+  */
+int GPIBPort::waitAsync(long &count)
+{
+    QMutexLocker locker(&asyncMutex);
+    while( asyncPending )
+        asyncFinished.wait( &asyncMutex );
+
+    count = asyncCount;
+    return ( ( asyncIbsta & ERR ) == ERR ) ? -1 : EXIT_SUCCESS;
+}
+
+/**
+  * @brief Abort the pending asynchronous transfer with ibstop.
+  *
+  * The transfer still ends through gpibNotify, with EABO; waitAsync returns then.
+  */
+int GPIBPort::abortAsync()
+{
+    int status = EXIT_SUCCESS;
+    if( isAsyncPending() ){
+        capture( driver->stop( device ) );
+        status = checkCall();
+    }
+    return status;
+}
+
+bool GPIBPort::isAsyncPending()
+{
+    QMutexLocker locker(&asyncMutex);
+    return asyncPending;
+}
+
+/**
+  * @brief Receive the CMPL notification of an asynchronous transfer.
+  *
+  * Runs in the driver notification thread, so it must not touch the UI.
+  *
+  * @return 0, the notification is not rearmed.
+  */
+int GPIBPort::gpibNotify(int ud, int LocalIbsta, int LocalIberr, long LocalIbcntl)
+{
+    Q_UNUSED(ud);
+    AsyncCompletion completion;
+    bool holdsBus;
+    {
+        QMutexLocker locker(&asyncMutex);
+        holdsBus = asyncHoldsBus;
+        asyncHoldsBus = false;
+        asyncIbsta = LocalIbsta;
+        asyncIberr = LocalIberr;
+        asyncCount = LocalIbcntl;
+        asyncPending = false;
+        completion = asyncCompletion;
+        asyncCompletion = AsyncCompletion();
+        asyncFinished.wakeAll();
     }
-#endif
+    if( holdsBus ) GPIBBusScheduler::board( BOARD_INDEX )->finishTransfer();
+    if( completion ) completion( LocalIbsta, LocalIberr, LocalIbcntl );
+    return 0;
+}
+
+/**
+  * @brief Arm the CMPL notification of an asynchronous transfer.
+  *
+  * Decided on the status of the ibwrta or ibrda itself: a transfer that did not
+  * start is finished at once, even if recover() has cleared the error since. A
+  * transfer that started keeps the bus until gpibNotify.
+  *
+  * @param started The status of the call that started the transfer.
+  * @param status The value checkCall() returned for it.
+  */
+int GPIBPort::armAsync(const GPIBStatus &started, int status)
+{
+    GPIBStatus failed = started;
+    if( !started.isError() ){
+        GPIBBusScheduler::board( BOARD_INDEX )->holdForTransfer();
+        {
+            QMutexLocker locker(&asyncMutex);
+            asyncHoldsBus = true;
+        }
+        capture( driver->notify( device, CMPL, this ) );
+        failed = lastStatus;
+        status = checkCall();
+        if( !failed.isError() ) return status;
+        driver->stop( device );
+    }
+    gpibNotify( device, failed.ibsta, failed.iberr, 0 );
+    return status;
+}
+
+/**
+  * @brief Mark the start of an asynchronous transfer.
+  *
+  * @return -1 if there is a previous GPIB error or another transfer is still pending.
+  */
+int GPIBPort::startAsync(const AsyncCompletion &completion)
+{
+    if( !isNoError() ) return -1;
+
+    QMutexLocker locker(&asyncMutex);
+    if( asyncPending ) return -1;
+
+    asyncPending = true;
+    asyncCompletion = completion;
+    asyncIbsta = 0;
+    asyncIberr = 0;
+    asyncCount = 0;
+    return EXIT_SUCCESS;
+}
+
+/**
+  * @brief Open a device GPIB connection.
+  */
+
+int GPIBPort::openConnection(int eos){
+    // Opening again is the way out of an error, so the port starts clean: the
+    // previous descriptor is given back and a new one is always acquired
+    setNoError(true);
+    if( device >= 0 ){
+        GPIBDescriptorPool::instance()->release( driver, device );
+        device = -1;
+    }
+
+    GPIBStatus opened = GPIBDescriptorPool::instance()->acquire( driver, BOARD_INDEX, address, SAD, timeout, EOT, eos, device );
+    if( !opened.isError() && device < 0 ){
+        opened.ibsta |= ERR;
+        opened.iberr = EDVR;
+    }
+    capture( opened );
+    core.attach( driver, device );
+    GPIBTrace::event( address, GPIB_TRACE_OPEN, lastStatus.ibsta, device );
+    serviceRequestMask = 0;
+    stateCache.invalidate();
+    int status = checkCall();
     setNoError(true);
     return status;
 }
@@ -214,10 +718,10 @@ int GPIBPort::openConnection(int eos){
   * @param instruction QString that contains the GPIB instruction desired.
   */
 int GPIBPort::write(QString instruction){
-    if( isNoError()) write(instruction.toLocal8Bit().data());
-    else {
-        //qDebug() << "ññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññññ";
-    }
+    // Setting already in the instrument
+    if( stateCacheEnabled && stateCache.isRedundant(instruction) ) return EXIT_SUCCESS;
+
+    if( isNoError()) return write(instruction.toLocal8Bit().data());
     return errors();
 }
 
@@ -227,12 +731,49 @@ int GPIBPort::write(QString instruction){
   * @param instruction A char sequence that contains the GPIB instruction desired.
   */
 int GPIBPort::write(char * instruction){
+    return write( instruction, strlen(instruction) );
+}
 
-    #if SHOW_GPIB_COMMANDS == 1
-            qDebug() << instruction;
-    #endif
-    if( isNoError()) ibwrt( device, instruction, strlen(instruction) );
-    return errors();
+/**
+  * @brief Write a desired GPIB instruction without any conversion or copy.
+  *
+  * @param data The bytes of the GPIB instruction desired. It does not need to be NUL terminated.
+  * @param length The number of bytes to send.
+  */
+int GPIBPort::write(const char *data, int length){
+    int status;
+    int attempt = 0;
+    do {
+        GPIBBusLock bus( BOARD_INDEX, address, busPriority );
+        GPIBLatencyProbe probe( address, GPIB_OP_WRITE );
+        if( isNoError()){
+            core.write( std::string_view( data, length ) );
+            capture( core.status() );
+            probe.setBytes( lastStatus.ibcnt );
+            GPIBTrace::transfer( address, GPIB_TRACE_WRITE, lastStatus.ibsta, data, lastStatus.ibcnt );
+        }
+        status = checkCall();
+    } while( status != EXIT_SUCCESS && transactionDepth == 0 && retryAfterError( attempt++ ) );
+
+    // Every path that writes ends here, so the cache sees all the settings sent
+    if( status == EXIT_SUCCESS && isNoError() ) stateCache.update( QString::fromLatin1( data, length ) );
+    return status;
+}
+
+/**
+  * @brief Write a command built by a SCPICommandTemplate, without converting it to QString.
+  *
+  * With the state cache enabled it goes through write(QString), as the cache keeps
+  * the settings as text. A command that did not fit in SCPI_COMMAND_SIZE bytes is
+  * not sent, as only part of it would be.
+  *
+  * @param command The command, e.g. SCPICommandFactory::VOLTAGE_SOURCE_LEVEL( level ).
+  * @return The write status, or -1 if the command is overflowed.
+  */
+int GPIBPort::write(const SCPICommand &command){
+    if( command.isOverflowed() ) return -1;
+    if( stateCacheEnabled ) return write( QString::fromLatin1( command.constData(), command.size() ) );
+    return write( command.constData(), command.size() );
 }
 
 /**
@@ -240,28 +781,107 @@ int GPIBPort::write(char * instruction){
   */
 int GPIBPort::remoteEnable()
 {
+    GPIBBusLock bus( BOARD_INDEX, address, busPriority );
     int result = 0;
-#ifndef TEST
     if( noError ){
         //ibsre( device, 1 ); // depracated
-        result = ibconfig( device, IbcSRE, 1);
-        errors();
+        capture( driver->config( device, IbcSRE, 1 ) );
+        result = lastStatus.ibsta;
+        checkCall();
     } else result = -1;
-#endif
     return result;
 }
 
+/**
+  * @brief Program the Service Request Enable register.
+  *
+  * @param mask Status Byte bits that raise SRQ (STB_MAV, STB_ESB, ...).
+  */
+int GPIBPort::enableServiceRequest(int mask)
+{
+    int status = write( SCPICommandFactory::SERVICE_REQUEST_ENABLE( mask ) );
+    if( status == EXIT_SUCCESS ) serviceRequestMask = mask;
+    return status;
+}
+
+/**
+  * @brief Wait until the device requests service for one of the given Status Byte bits.
+  *
+  * Blocks on ibwait(RQS|TIMO) instead of sleeping a fixed time. The serial poll that
+  * follows clears the request and tells which bits are set. The bits are added to
+  * the Service Request Enable register if they were not enabled yet.
+  *
+  * The whole wait, including the requests for other bits, is bounded by the timeout
+  * of the port: set it with GPIBTimeoutGuard and measurementTimeout() when waiting
+  * for readings. A failed serial poll ends the wait, even if the port recovers.
+  *
+  * @param mask Status Byte bits to wait for.
+  */
+int GPIBPort::waitForServiceRequest(int mask)
+{
+    GPIBLatencyProbe probe( address, GPIB_OP_SRQ_WAIT );
+    int status = EXIT_SUCCESS;
+    if( ( serviceRequestMask & mask ) != mask ) status = enableServiceRequest( serviceRequestMask | mask );
+
+    long limit = timeoutMilliseconds( timeout );
+    QElapsedTimer waited;
+    waited.start();
+
+    char spr = 0;
+    while( isNoError() ){
+        capture( driver->wait( device, RQS | TIMO ) );
+        GPIBTrace::event( address, GPIB_TRACE_SRQ_WAIT, lastStatus.ibsta, mask );
+        status = checkCall();
+        if( status != EXIT_SUCCESS ) break;
+
+        if( lastStatus.isTimeout() || ( limit >= 0 && waited.hasExpired( limit ) ) ){
+            reportError( GPIB_ERROR_TIMEOUT, lastStatus.ibsta, lastStatus.iberr );
+            if( recoveryPolicy.enabled ) recover( GPIB_ERROR_TIMEOUT );
+            status = -1;
+            break;
+        }
+
+        GPIBBusLock bus( BOARD_INDEX, address, BUS_PRIORITY_CRITICAL );
+        capture( driver->serialPoll( device, &spr ) );
+        GPIBTrace::event( address, GPIB_TRACE_SERIAL_POLL, lastStatus.ibsta, (unsigned char)spr );
+        status = checkCall();
+        if( status != EXIT_SUCCESS ) break;
+        if( ( spr & mask ) != 0 ) break;
+    }
+    return status;
+}
+
+/**
+  * @brief Program the Service Request Enable register so that MAV raises SRQ.
+  */
+int GPIBPort::enableMessageAvailableRequest()
+{
+    return enableServiceRequest( serviceRequestMask | STB_MAV );
+}
+
+/**
+  * @brief Wait until the device has a response in its output queue.
+  *
+  * Used instead of a fixed sleep so the read can be issued as soon as the
+  * instrument finishes the measure.
+  */
+int GPIBPort::waitForMessageAvailable()
+{
+    return waitForServiceRequest( STB_MAV );
+}
+
 /**
   * @brief Clear a specific device
   */
 void GPIBPort::clearDevice()
 {
-#ifndef TEST
+    GPIBBusLock bus( BOARD_INDEX, address, busPriority );
     if( noError){
-        ibclr( device );
-        errors();
+        capture( driver->clear( device ) );
+        GPIBTrace::event( address, GPIB_TRACE_CLEAR, lastStatus.ibsta, 0 );
+        checkCall();
     }
-#endif
+    stateCache.invalidate();
 }
 
 /**
@@ -269,120 +889,304 @@ void GPIBPort::clearDevice()
   */
 
 void GPIBPort::closeConnection(){
-#ifndef TEST
+    GPIBBusLock bus( BOARD_INDEX, address, busPriority );
     // Force the device into local mode
     if( noError ){
-        ibloc( device );
-        errors(); // Just check for errors if there is no previous errors
+        capture( driver->goToLocal( device ) );
+        checkCall(); // Just check for errors if there is no previous errors
         // avoids errors loops
     }
-#endif
 }
 
 /**
   * @brief Close device
+  *
+  * The descriptor goes back to the pool, which takes it offline (ibonl 0) once it
+  * has been idle for DESCRIPTOR_IDLE_TIMEOUT. Opening the device again before that
+  * reuses it.
   */
 
 void GPIBPort::disable(){
-#ifndef TEST
-    // Force the device into local mode
-    if( noError ){
-        ibonl(device, 0);
-        errors();
+    if( device >= 0 ){
+        GPIBDescriptorPool::instance()->release( driver, device );
+        device = -1;
     }
-#endif
+    core.attach( driver, -1 );
 }
 
 bool GPIBPort::isNoError() {return noError;}
 
 void GPIBPort::setNoError(bool state) {noError = state;}
 
+/**
+  * @brief Skip the writes that would not change the instrument settings.
+  *
+  * When enabled, write(QString) does not send a setting whose value matches the last
+  * one sent (see SCPIStateCache). Every synchronous write updates the cache, enabled
+  * or not; writeAsync makes it forget the settings it sends. The cache is cleared by
+  * *RST, clearDevice() and errors.
+  */
+void GPIBPort::setStateCacheEnabled(bool state)
+{
+    stateCacheEnabled = state;
+    stateCache.invalidate();
+}
+
+bool GPIBPort::isStateCacheEnabled() {return stateCacheEnabled;}
+
+SCPIStateCache *GPIBPort::getStateCache() {return &stateCache;}
+
 /**
   * @brief Detect if a GPIB error just happened.
+  *
+  * The failed call is reported once, however many times the operation that made it
+  * is checked. A port left in error by a previous call returns -1 without a report.
   */
 
 int GPIBPort::errors(){
-    int status = EXIT_SUCCESS;
-#ifndef TEST
-
-    if( ( ibsta & ERR ) == ERR ) {
-        //We have and error!
-        //Extracting type of error
-        QString errorMessageText = "GPIB Error: ";
-        switch( iberr ){
-        case EDVR:
-            errorMessageText.append("System error.");
-            status = -1;break;
-        case ECIC:
-            errorMessageText.append("Function requires GPIB board to be CIC.");
-            status = -1;break;
-        case ENOL:
-            errorMessageText.append("Write function detected no Listeners.");
-            status = -2;break;
-        case EADR:
-            errorMessageText.append("Interface board not addressed correctly.");
-            status = -1;break;
-        case EARG:
-            errorMessageText.append("Invalid argument to function call.");
-            status = -1;break;
-        case ESAC:
-            errorMessageText.append("Function requires GPIB board to be SAC.");
-            status = -1;break;
-        case EABO:
-            errorMessageText.append("I/O operation aborted.");
-            status = -1;break;
-        case ENEB:
-            errorMessageText.append("Non-existent interface board.");
-            status = -1;break;
-        case EDMA:
-            errorMessageText.append("DMA hardware error detected.");
-            status = -1;break;
-        case EOIP:
-            errorMessageText.append("I/O operation started before previous operation completed.");
-            status = -1;break;
-        case ECAP:
-            errorMessageText.append("No capability for intended operation.");
-            status = -1;break;
-        case EFSO:
-            errorMessageText.append("File system operation error.");
-            status = -1;break;
-        case EBUS:
-            errorMessageText.append("Command error during device call.");
-            status = -1;break;
-        case ESTB:
-            errorMessageText.append("Serial poll status byte lost.");
-            status = -1;break;
-        case ESRQ:
-            errorMessageText.append("SRQ remains asserted.");
-            status = -1;break;
-        case ETAB:
-            errorMessageText.append("The return buffer is full.");
-            status = -1;break;
-        }
-        errorMessage( errorMessageText );
+    if( !lastStatus.isError() ) return isNoError() ? EXIT_SUCCESS : -1;
+
+    int code = errorCode( lastStatus.ibsta, lastStatus.iberr );
+    if( !statusReported ){
+        statusReported = true;
+        stateCache.invalidate();
+        reportError( code, lastStatus.ibsta, lastStatus.iberr );
     }
-#endif
+    return ( code == GPIB_ERROR_NO_LISTENERS ) ? -2 : -1;
+}
+
+/**
+  * @brief Check the driver call the port has just made.
+  *
+  * Reported as errors() does; with a recovery policy, a failed call is also
+  * recovered from here, once, so checking it again does not spend more budget.
+  */
+
+int GPIBPort::checkCall(){
+    bool failed = !statusReported && lastStatus.isError();
+    int code = errorCode( lastStatus.ibsta, lastStatus.iberr );
+    int status = errors();
+    if( failed && recoveryPolicy.enabled ) recover( code );
     return status;
 }
 
 /**
-  * @brief Pop up errors
+  * @brief Map the status of the last driver call to a GPIBErrorCode.
+  *
+  * @param status The ibsta of the call.
+  * @param error The iberr of the call.
+  */
+
+int GPIBPort::errorCode(int status, int error)
+{
+    if( ( status & TIMO ) == TIMO ) return GPIB_ERROR_TIMEOUT;
+
+    switch( error ){
+    case EDVR: return GPIB_ERROR_SYSTEM;
+    case ECIC: return GPIB_ERROR_NOT_CIC;
+    case ENOL: return GPIB_ERROR_NO_LISTENERS;
+    case EADR: return GPIB_ERROR_NOT_ADDRESSED;
+    case EARG: return GPIB_ERROR_INVALID_ARGUMENT;
+    case ESAC: return GPIB_ERROR_NOT_SAC;
+    case EABO: return GPIB_ERROR_ABORTED;
+    case ENEB: return GPIB_ERROR_NO_BOARD;
+    case EDMA: return GPIB_ERROR_DMA;
+    case EOIP: return GPIB_ERROR_IN_PROGRESS;
+    case ECAP: return GPIB_ERROR_NO_CAPABILITY;
+    case EFSO: return GPIB_ERROR_FILE_SYSTEM;
+    case EBUS: return GPIB_ERROR_BUS;
+    case ESTB: return GPIB_ERROR_STATUS_BYTE_LOST;
+    case ESRQ: return GPIB_ERROR_SRQ_STUCK;
+    case ETAB: return GPIB_ERROR_TABLE_FULL;
+    }
+    return GPIB_ERROR_UNKNOWN;
+}
+
+/**
+  * @brief Set how the port recovers from transient errors. Disabled by default.
+  */
+
+void GPIBPort::setRecoveryPolicy(const GPIBRecoveryPolicy &policy)
+{
+    recoveryPolicy = policy;
+    recoveriesInWindow = 0;
+    recoveryWindow.invalidate();
+}
+
+GPIBRecoveryPolicy GPIBPort::getRecoveryPolicy() {return recoveryPolicy;}
+
+/**
+  * @brief Bring the device and the bus back to a usable state after an error.
+  *
+  * The action depends on the error (see GPIBRecoveryPolicy). When it succeeds the
+  * error flag is cleared, so the next operations are not skipped.
+  *
+  * @param code The GPIBErrorCode of the error.
+  * @return EXIT_SUCCESS if the port can be used again, -1 otherwise.
+  */
+
+int GPIBPort::recover(int code)
+{
+    if( device < 0 || !takeRecoveryBudget() ) return -1;
+
+    // The status of the failed call is kept unless the recovery succeeds, so a
+    // failed recovery is not reported as a new error
+    GPIBBusLock bus( BOARD_INDEX, address, BUS_PRIORITY_CRITICAL );
+    GPIBStatus result;
+    short listen = 0;
+    switch( code ){
+    case GPIB_ERROR_TIMEOUT:
+    case GPIB_ERROR_ABORTED:
+        result = driver->clear( device );
+        break;
+    case GPIB_ERROR_NO_LISTENERS:
+        result = driver->setPrimaryAddress( device, address );
+        if( !result.isError() ) result = driver->setSecondaryAddress( device, SAD );
+        if( !result.isError() ) result = driver->findListener( BOARD_INDEX, address, SAD, &listen );
+        if( !result.isError() && !listen ) return -1;
+        break;
+    case GPIB_ERROR_BUS:
+    case GPIB_ERROR_NOT_CIC:
+    case GPIB_ERROR_NOT_ADDRESSED:
+        result = driver->interfaceClear( BOARD_INDEX );
+        break;
+    default:
+        return -1;
+    }
+    if( result.isError() ) return -1;
+
+    capture( result );
+    GPIBTrace::event( address, GPIB_TRACE_RECOVER, result.ibsta, code );
+    stateCache.invalidate();
+    setNoError(true);
+    return EXIT_SUCCESS;
+}
+
+/**
+  * @brief Decide if a failed operation is tried again, waiting the backoff time.
+  *
+  * @param attempt Number of retries already done.
+  */
+
+bool GPIBPort::retryAfterError(int attempt)
+{
+    if( !recoveryPolicy.enabled || !isNoError() || attempt >= recoveryPolicy.maxRetries ) return false;
+
+    int backoff = recoveryPolicy.initialBackoff;
+    for( int i = 0; i < attempt && backoff < recoveryPolicy.maxBackoff; i++ ) backoff *= 2;
+    QThread::msleep( qMin( backoff, recoveryPolicy.maxBackoff ) );
+    return true;
+}
+
+/**
+  * @brief Count a recovery against the budget of the current window.
+  *
+  * @return false if the budget of the window is already spent.
+  */
+
+bool GPIBPort::takeRecoveryBudget()
+{
+    if( !recoveryWindow.isValid() || recoveryWindow.hasExpired( recoveryPolicy.budgetWindow ) ){
+        recoveryWindow.start();
+        recoveriesInWindow = 0;
+    }
+    if( recoveriesInWindow >= recoveryPolicy.budget ) return false;
+
+    recoveriesInWindow++;
+    return true;
+}
+
+/**
+  * @brief Queue an error event and notify it.
+  *
+  * Never blocks, so it can be called from the I/O thread or the driver threads.
+  *
+  * @param code A GPIBErrorCode.
+  * @param status The ibsta of the failed call.
+  * @param error The iberr of the failed call.
+  */
+
+void GPIBPort::reportError(int code, int status, int error)
+{
+    GPIBErrorEvent event;
+    event.code = code;
+    event.address = address;
+    event.ibsta = status;
+    event.iberr = error;
+    event.timestamp = QElapsedTimer::msecsSinceReference();
+    GPIBTrace::event( address, GPIB_TRACE_ERROR, status, code );
+
+    errorQueue.push( event );
+    lastErrorCode.store( code );
+    errorMessage( gpibErrorText(code) );
+}
+
+/**
+  * @brief Report an error without blocking the calling thread.
+  *
+  * Marks the port as failed and emits errorSignal. The typed events are taken with
+  * takeError.
   *
   * @param erroType A QString that holds the error type.
   */
 
 void GPIBPort::errorMessage(QString errorType)
 {
-    QMessageBox errorBox;
-    errorBox.setIcon( QMessageBox::Critical );
-
     #if DEBUG==1
         qDebug()<<"GPIB-PORT("+QString::number(this->getAddress())+"): void GPIBPort::errorMessage(QString errorType): " + errorType.toLocal8Bit().constData();
+    #else
+        Q_UNUSED(errorType);
     #endif
 
-    errorBox.setText( errorType.toLocal8Bit().constData());
-    errorBox.exec();
     setNoError(false);
+    emit errorSignal();
+}
+
+/**
+  * @brief Take the oldest error event reported by the port.
+  *
+  * @param event Set to the event.
+  * @return false if there are no pending events.
+  */
+
+bool GPIBPort::takeError(GPIBErrorEvent &event) {return errorQueue.take(event);}
+
+/**
+  * @brief The GPIBErrorCode of the last error, GPIB_ERROR_NONE if there was none.
+  */
+
+int GPIBPort::lastError() {return lastErrorCode.load();}
+
+/**
+  * @brief Number of error events lost because the queue was full when they were reported.
+  *
+  * A value that grows means takeError is not called often enough.
+  */
+
+unsigned int GPIBPort::droppedErrors() const {return errorQueue.dropped();}
+
+/**
+  * @brief ibsta, iberr and ibcnt of the last driver call made by a GPIBPort on the calling thread.
+  *
+  * Read it right after an operation to get the details of its int status. It is not
+  * changed by the operations of other threads. The errors of a port are decided on
+  * its own status, not on this one.
+  */
+
+GPIBStatus GPIBPort::callStatus() {return threadStatus;}
+
+/**
+  * @brief Keep the status of a driver call made by this port.
+  *
+  * The port reports its own status, so the calls of other ports on the same thread
+  * do not change it; callStatus() gets a copy as well.
+  */
+
+void GPIBPort::capture(const GPIBStatus &status)
+{
+    lastStatus = status;
+    threadStatus = status;
+    statusReported = false;
 }
 
 /**
@@ -393,12 +1197,14 @@ void GPIBPort::errorMessage(QString errorType)
 
 QString GPIBPort::sreQuery()
 {
-    QString output = QString( "*SRE?" );
+    if( !isNoError() ) return QString();
 
-    if( isNoError() ) write( output.toLocal8Bit().data() );
+    GPIBBusLock bus( BOARD_INDEX, address, BUS_PRIORITY_CRITICAL );
+    GPIBLatencyProbe probe( address, GPIB_OP_STATUS_QUERY );
+    QString output = QString( "*SRE?" );
 
     QVariant qVarRes;
-    read(READBUFFER_SIZE_MAX, qVarRes);
+    if( write( output.toLocal8Bit().data() ) == EXIT_SUCCESS ) read(READBUFFER_SIZE_MAX, qVarRes);
     return qVarRes.toString();
 }
 
@@ -410,27 +1216,15 @@ QString GPIBPort::sreQuery()
 
 int GPIBPort::stbQuery()
 {
-    QString output = QString( "*STB?" );
+    if( !isNoError() ) return 0;
 
-#ifndef TEST
+    GPIBBusLock bus( BOARD_INDEX, address, BUS_PRIORITY_CRITICAL );
+    GPIBLatencyProbe probe( address, GPIB_OP_STATUS_QUERY );
+    QString output = QString( "*STB?" );
 
-    if( isNoError() ) write( output.toLocal8Bit().data() );
     QVariant qVarRes;
-    read(READBUFFER_SIZE_DEFAULT,qVarRes);
-    QByteArray statusRegister = qVarRes.toByteArray();
-
-    int i = 0;
-    while( statusRegister.at( i ) != '\n' )
-        i++;
-
-    statusRegister.truncate(i);
-    return statusRegister.toInt();
-
-#else
-
-    return 0;
-
-#endif
+    if( write( output.toLocal8Bit().data() ) == EXIT_SUCCESS ) read(READBUFFER_SIZE_DEFAULT,qVarRes);
+    return qVarRes.toByteArray().toInt();
 }
 
 /**
@@ -441,12 +1235,14 @@ int GPIBPort::stbQuery()
 
 QVariant GPIBPort::esrQuery()
 {
-    QString output = QString( "*ESR?" );
+    if( !isNoError() ) return QVariant();
 
-    if( isNoError() ) write( output.toLocal8Bit().data() );
+    GPIBBusLock bus( BOARD_INDEX, address, BUS_PRIORITY_CRITICAL );
+    GPIBLatencyProbe probe( address, GPIB_OP_STATUS_QUERY );
+    QString output = QString( "*ESR?" );
 
     QVariant qVarRes;
-    read(READBUFFER_SIZE_MAX, qVarRes);
+    if( write( output.toLocal8Bit().data() ) == EXIT_SUCCESS ) read(READBUFFER_SIZE_MAX, qVarRes);
     return qVarRes;
 }
 
@@ -458,12 +1254,14 @@ QVariant GPIBPort::esrQuery()
 
 QVariant GPIBPort::eseQuery()
 {
-    QString output = QString( "*ESE?" );
+    if( !isNoError() ) return QVariant();
 
-    if( isNoError() ) write( output.toLocal8Bit().data() );
+    GPIBBusLock bus( BOARD_INDEX, address, BUS_PRIORITY_CRITICAL );
+    GPIBLatencyProbe probe( address, GPIB_OP_STATUS_QUERY );
+    QString output = QString( "*ESE?" );
 
     QVariant qVarRes;
-    read(READBUFFER_SIZE_MAX, qVarRes);
+    if( write( output.toLocal8Bit().data() ) == EXIT_SUCCESS ) read(READBUFFER_SIZE_MAX, qVarRes);
     return qVarRes;
 }
 
@@ -475,12 +1273,14 @@ QVariant GPIBPort::eseQuery()
 
 QVariant GPIBPort::oerQuery()
 {
-    QString output = QString( ":STAT:OPER:EVEN?" );
+    if( !isNoError() ) return QVariant();
 
-    if( isNoError() ) write( output.toLocal8Bit().data() );
+    GPIBBusLock bus( BOARD_INDEX, address, BUS_PRIORITY_CRITICAL );
+    GPIBLatencyProbe probe( address, GPIB_OP_STATUS_QUERY );
+    QString output = QString( ":STAT:OPER:EVEN?" );
 
     QVariant qVarRes;
-    read(READBUFFER_SIZE_MAX, qVarRes);
+    if( write( output.toLocal8Bit().data() ) == EXIT_SUCCESS ) read(READBUFFER_SIZE_MAX, qVarRes);
     return qVarRes;
 }
 
@@ -492,12 +1292,14 @@ QVariant GPIBPort::oerQuery()
 
 QVariant GPIBPort::merQuery()
 {
-    QString output = QString( ":STAT:MEAS:EVEN?" );
+    if( !isNoError() ) return QVariant();
 
-    if( isNoError() ) write( output.toLocal8Bit().data() );
+    GPIBBusLock bus( BOARD_INDEX, address, BUS_PRIORITY_CRITICAL );
+    GPIBLatencyProbe probe( address, GPIB_OP_STATUS_QUERY );
+    QString output = QString( ":STAT:MEAS:EVEN?" );
 
     QVariant qVarRes;
-    read(READBUFFER_SIZE_MAX, qVarRes);
+    if( write( output.toLocal8Bit().data() ) == EXIT_SUCCESS ) read(READBUFFER_SIZE_MAX, qVarRes);
     return qVarRes;
 }
 
@@ -509,43 +1311,38 @@ QVariant GPIBPort::merQuery()
 
 QVariant GPIBPort::qerQuery()
 {
-    QString output = QString( ":STAT:QUES:EVEN?" );
+    if( !isNoError() ) return QVariant();
 
-    if( isNoError() ) write( output.toLocal8Bit().data() );
+    GPIBBusLock bus( BOARD_INDEX, address, BUS_PRIORITY_CRITICAL );
+    GPIBLatencyProbe probe( address, GPIB_OP_STATUS_QUERY );
+    QString output = QString( ":STAT:QUES:EVEN?" );
 
     QVariant qVarRes;
-    read(READBUFFER_SIZE_MAX, qVarRes);
+    if( write( output.toLocal8Bit().data() ) == EXIT_SUCCESS ) read(READBUFFER_SIZE_MAX, qVarRes);
     return qVarRes;
 }
 
 int GPIBPort::checkPresence()
 {
-    int status = EXIT_SUCCESS;
+    GPIBBusLock bus( BOARD_INDEX, address, busPriority );
 
-#ifndef TEST
     QString output = QString( "*IDN?" );
     //qDebug() << output.toLocal8Bit().data();
 
-    if( isNoError() )
-    {
-        write( output.toLocal8Bit().data());
-    }
-    status = errors();
+    int status = write( output.toLocal8Bit().data() );
     QVariant qVarRes;
-    read(200, qVarRes);
-    status = errors();
-#endif
+    if( status == EXIT_SUCCESS ) status = read(200, qVarRes);
     return status;
 }
 
 void GPIBPort::readQueryAsCharArray(char *message, const int size)
 {
-    QString output = QString(":READ?");
-    qDebug() << output.toLocal8Bit().data();
-
     if(isNoError())
-        write(output.toLocal8Bit().data());
-    read(message, size);
+        write(READ_QUERY, READ_QUERY_LENGTH);
+    if( read(message, size) == EXIT_SUCCESS ){
+        long length = stripTerminator( message, lastStatus.ibcnt );
+        if( length < size ) message[length] = '\0';
+    }
 }
 int GPIBPort::getDevice() const
 {
@@ -555,8 +1352,26 @@ int GPIBPort::getDevice() const
 void GPIBPort::setDevice(int value)
 {
     device = value;
+    core.attach( driver, device );
 }
 
+/**
+  * @brief Set the backend the port talks to the bus through.
+  *
+  * Must be called before openConnection. The port does not own the driver.
+  *
+  * @param driver A GPIBDriver, e.g. a SimulatedK24xx to run without hardware.
+  */
+void GPIBPort::setDriver(GPIBDriver *driver)
+{
+    if( device >= 0 ) GPIBDescriptorPool::instance()->release( this->driver, device );
+    this->driver = driver;
+    device = -1;
+    core.attach( driver, -1 );
+}
+
+GPIBDriver *GPIBPort::getDriver() {return driver;}
+
 /**
   * @brief Trigger and reads Status Byte Register.
   *
@@ -7,22 +7,73 @@
 #include "./debugTools/debug.h"
 #include "./models/ValidInstrumentsParameters.h"
 #include "./debugTools/debug.h"
+#include "./gpib/ieee4882Block.h"
+#include "./gpib/SCPICommandFactory.h"
+#include "./gpib/SCPIStateCache.h"
+#include "./gpib/scpiDevice.h"
+#include "./gpib/parallelCommunications/gpib/gpibBusScheduler.h"
+#include "./gpib/parallelCommunications/gpib/gpibErrorQueue.h"
 
-#include <QMessageBox>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QByteArray>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include <atomic>
+#include <functional>
+#include <string_view>
 
 #define BOARD_INDEX 0
 #define SAD 0
 #define READ_SIZE 100
+#define READ_CHUNK_SIZE 4096
+
+#define READ_QUERY ":READ?"
+#define READ_QUERY_LENGTH 6
 
 #define TIMEOUT_1s T1s
 #define TIMEOUT_3s T3s
 #define TIMEOUT_10s T10s
 #define TIMEOUT_30s T30s
 #define TIMEOUT_100s T100s
+#define TIMEOUT_300s T300s
+#define TIMEOUT_1000s T1000s
 #define NEVERTIMEOUT TNONE
+#define DEFAULT_TIMEOUT TIMEOUT_3s
+
+/**
+  * Expected measurement time, used to choose the timeout of the operations that
+  * wait for readings (see GPIBPort::measurementTimeout).
+  *  - LINE_CYCLE_MS = one power line cycle, 50 Hz is the longest
+  *  - CONVERSIONS_PER_READING = signal, reference and zero with auto zero on
+  *  - READING_OVERHEAD_MS = settling and processing of every reading
+  *  - TIMEOUT_BASE_MS and TIMEOUT_MARGIN = timeout = base + margin * expected time
+  */
+#define LINE_CYCLE_MS 20
+#define CONVERSIONS_PER_READING 3
+#define READING_OVERHEAD_MS 5
+#define TIMEOUT_BASE_MS 1000
+#define TIMEOUT_MARGIN 2
 
 #define EOT 1
 
+/**
+  * Status Byte bits
+  *  - MAV = Message Available in the output queue
+  *  - ESB = Event Summary Bit (enabled Standard Event, e.g. OPC)
+  *  - MSS = Master Summary Status (RQS when serial polled)
+  */
+#define STB_MAV 0x10
+#define STB_ESB 0x20
+#define STB_MSS 0x40
+
+/**
+  * Standard Event Status bits
+  *  - OPC = Operation Complete
+  */
+#define ESR_OPC 0x01
+
 #define FORMAT_DATA_SIZE    14 * 3
 /**
   * End Of String
@@ -31,17 +82,57 @@
   */
 #define EOS 0
 
-#ifndef TEST
-    #ifdef  NI_PCI_GPIB
-        #include <windows.h>
-        #include "gpib/ni488.h"
-    #elif   AD_GPIB
-        #include "./gpib/Adgpib.h"
-        #include "./gpib/gpib_user.h"
-    #endif
-#endif
+#include "./gpib/parallelCommunications/gpib/gpibDriver.h"
+#include "./gpib/parallelCommunications/gpib/gpibDescriptorPool.h"
+#include "./gpib/parallelCommunications/gpib/gpibLatencyStats.h"
+#include "./gpib/parallelCommunications/gpib/gpibTrace.h"
+
+/**
+  * Called when an asynchronous transfer ends, from the driver notification thread.
+  * Receives the ibsta, iberr and byte count of the transfer.
+  */
+typedef std::function<void(int, int, long)> AsyncCompletion;
 
-class GPIBPort: public ParallelPort{
+/**
+  * @brief How GPIBPort recovers from transient bus errors.
+  *
+  *  - Timeout and EABO: device clear (ibclr)
+  *  - ENOL: address the device again and check it listens (ibpad, ibsad, ibln)
+  *  - EBUS, ECIC, EADR: interface clear (ibsic)
+  *
+  * After a successful recovery the failed write or query is retried up to maxRetries
+  * times, waiting initialBackoff ms before the first retry and doubling it up to
+  * maxBackoff. No more than budget recoveries are done within budgetWindow ms; once
+  * the budget is spent the port stays in error as without a policy.
+  */
+struct GPIBRecoveryPolicy
+{
+    bool enabled;
+    int  maxRetries;
+    int  initialBackoff;
+    int  maxBackoff;
+    int  budget;
+    int  budgetWindow;
+
+    GPIBRecoveryPolicy()
+    {
+        enabled = false;
+        maxRetries = 3;
+        initialBackoff = 10;
+        maxBackoff = 1000;
+        budget = 20;
+        budgetWindow = 60000;
+    }
+};
+
+/**
+  * @brief Qt port of one instrument, on top of SCPIDevice.
+  *
+  * The synchronous reads and writes are done by SCPIDevice on the same descriptor;
+  * the port adds the bus scheduling, the retries, the state cache, the trace and
+  * the error queue.
+  */
+class GPIBPort: public ParallelPort, public GpibNotifyReceiver{
 
     Q_OBJECT
 public:
@@ -56,21 +147,62 @@ public:
     int      checkPresence();
     int      write( QString instruction);
     int      write( char *instruction );
+    int      write( const char *data, int length );
+    int      write( const SCPICommand &command );
     int      read (int size, QVariant &result);
     int      read( char * message, int size );
+    int      readInto( char *buffer, int capacity, int &count );
+    int      readInto( char *buffer, int capacity, std::string_view &response );
+    int      readAll( QByteArray &result, int chunkSize = READ_CHUNK_SIZE, bool keepTerminator = false );
+    int      readStream( const std::function<void(const char *, int)> &consumer, int chunkSize = READ_CHUNK_SIZE );
+    int      readBinaryBlock( QVector<double> &values, const int format, const bool swapped );
     int      sendReadQueryAndGetResultAsCharArray( char* message, int bytesToRead );
     int      sendReadQueryAndGetResultAsString(int size, QString &result);
+    int      sendReadQueryAndReadInto( char *buffer, int capacity, int &count );
+    int      sendReadQueryAndReadInto( char *buffer, int capacity, std::string_view &reading );
+
+    int      writeAsync( const char *data, int length, const AsyncCompletion &completion = AsyncCompletion() );
+    int      readAsync( char *buffer, int capacity, const AsyncCompletion &completion = AsyncCompletion() );
+    int      waitAsync( long &count );
+    int      abortAsync();
+    bool     isAsyncPending();
+    int      gpibNotify( int ud, int LocalIbsta, int LocalIberr, long LocalIbcntl );
     int      remoteEnable();
+    int      enableServiceRequest( int mask );
+    int      waitForServiceRequest( int mask );
+    int      enableMessageAvailableRequest();
+    int      waitForMessageAvailable();
     void     clearDevice();
     bool     isNoError();
     void     setNoError(bool state);
+    bool     takeError( GPIBErrorEvent &event );
+    int      lastError();
+    unsigned int droppedErrors() const;
+    static GPIBStatus callStatus();
+
+    void     setRecoveryPolicy(const GPIBRecoveryPolicy &policy);
+    GPIBRecoveryPolicy getRecoveryPolicy();
+    int      recover( int code );
+
+    void     setStateCacheEnabled(bool state);
+    bool     isStateCacheEnabled();
+    SCPIStateCache *getStateCache();
 
     int      setTimeout (int timo);
+    int      getTimeout();
+    long     expectedMeasurementTime();
+    bool     knownSetting( const QString &header, QString &value );
+    int      measurementTimeout();
+    static int timeoutFor( long milliseconds );
+    static long timeoutMilliseconds( int timo );
     void     setAddress(int addr);
     int      getAddress();
+    void     setBusPriority(int priority);
+    int      getBusPriority();
 
     int      testInstrunction(QString instruction);
     int      allResgistersQueryTest();
+    int      eventRegistersQuery( int &esr, int &oer, int &mer, int &qer );
 
     int      stbQuery();
     QString  sreQuery();
@@ -85,14 +217,55 @@ public:
     int getDevice() const;
     void setDevice(int value);
 
+    void setDriver(GPIBDriver *driver);
+    GPIBDriver *getDriver();
+
 private:
     int     address;
     bool    noError = true;
-    int     device;
+    int     device = -1;
+    GPIBDriver *driver = GPIBDriver::defaultDriver();
+    SCPIDevice  core = SCPIDevice( driver );
+    GPIBStatus  lastStatus;
+    bool        statusReported = true;
+    static thread_local GPIBStatus threadStatus;
+    QByteArray chunkBuffer;
+    int     busPriority = BUS_PRIORITY_NORMAL;
+    SCPIStateCache stateCache;
+    bool    stateCacheEnabled = false;
+    int     serviceRequestMask = 0;
+    int     timeout = DEFAULT_TIMEOUT;
+    GPIBErrorQueue   errorQueue;
+    std::atomic<int> lastErrorCode { GPIB_ERROR_NONE };
+    GPIBRecoveryPolicy recoveryPolicy;
+    QElapsedTimer   recoveryWindow;
+    int     recoveriesInWindow = 0;
+    int     transactionDepth = 0;
+
+    QMutex          asyncMutex;
+    QWaitCondition  asyncFinished;
+    bool            asyncPending = false;
+    bool            asyncHoldsBus = false;
+    AsyncCompletion asyncCompletion;
+    QByteArray      asyncWriteBuffer;
+    int             asyncIbsta = 0;
+    int             asyncIberr = 0;
+    long            asyncCount = 0;
+
+    int      startAsync( const AsyncCompletion &completion );
+    int      armAsync( const GPIBStatus &started, int status );
+    void     capture( const GPIBStatus &status );
 
 protected:
     int      errors();
+    int      checkCall();
+    void     reportError( int code, int status, int error );
     void     errorMessage( QString errorType );
+    static int errorCode( int status, int error );
+    bool     retryAfterError( int attempt );
+    bool     takeRecoveryBudget();
+
+    friend class GPIBTimeoutGuard;
 
 signals:
     void     errorSignal();
@@ -100,4 +273,36 @@ signals:
 
 };
 
+/**
+  * @brief Changes the timeout of a port for the lifetime of the object.
+  *
+  * Putting the timeout back does not change callStatus(): it keeps the status of
+  * the last operation done under the guard, unless the ibtmo itself fails.
+  */
+class GPIBTimeoutGuard
+{
+public:
+    GPIBTimeoutGuard(GPIBPort *port, int timo)
+    {
+        this->port = port;
+        previous = port->getTimeout();
+        if( timo != previous ) port->setTimeout(timo);
+    }
+    ~GPIBTimeoutGuard()
+    {
+        if( port->getTimeout() == previous ) return;
+        GPIBStatus status = port->lastStatus;
+        bool reported = port->statusReported;
+        port->setTimeout(previous);
+        if( !port->lastStatus.isError() ){
+            port->capture( status );
+            port->statusReported = reported;
+        }
+    }
+
+private:
+    GPIBPort *port;
+    int previous;
+};
+
 #endif // GPIBPORT_H
@@ -0,0 +1,83 @@
+#include "./gpib/parallelCommunications/gpib/gpibQueryPipeline.h"
+
+/**
+  * @brief Constructor
+  *
+  * @param port The GPIBPort of the instrument.
+  */
+GPIBQueryPipeline::GPIBQueryPipeline(GPIBPort *port)
+{
+    this->port = port;
+}
+
+/**
+  * @brief Queries that were not flushed get an empty response.
+  */
+GPIBQueryPipeline::~GPIBQueryPipeline()
+{
+    complete( QByteArray() );
+}
+
+/**
+  * @brief Add a query to the next program message.
+  *
+  * A leading ":" is added to headers that do not have one, so every query is parsed
+  * from the root of the command tree.
+  *
+  * @param query A single query, e.g. "*ESR?".
+  * @return The future of its response, without the terminator.
+  */
+std::future<QByteArray> GPIBQueryPipeline::enqueue(const QByteArray &query)
+{
+    if( !message.isEmpty() ) message.append( ';' );
+    if( !query.startsWith( ':' ) && !query.startsWith( '*' ) ) message.append( ':' );
+    message.append( query );
+
+    pending.emplace_back();
+    return pending.back().get_future();
+}
+
+/**
+  * @brief Send the queued queries and hand out their responses.
+  *
+  * The bus is held from the write until the response is read.
+  *
+  * @return EXIT_SUCCESS or the GPIB error status of the write or the read.
+  */
+int GPIBQueryPipeline::flush()
+{
+    if( pending.empty() ) return EXIT_SUCCESS;
+
+    GPIBBusLock bus( BOARD_INDEX, port->getAddress(), BUS_PRIORITY_CRITICAL );
+    GPIBLatencyProbe probe( port->getAddress(), GPIB_OP_STATUS_QUERY );
+
+    QByteArray response;
+    int status = -1;
+    if( port->isNoError() ) status = port->write( message.constData(), message.size() );
+    if( status == EXIT_SUCCESS ) status = port->readAll( response );
+    probe.setBytes( response.size() );
+
+    complete( status == EXIT_SUCCESS ? response : QByteArray() );
+    message.clear();
+    return status;
+}
+
+int GPIBQueryPipeline::count() const {return (int)pending.size();}
+
+bool GPIBQueryPipeline::isEmpty() const {return pending.empty();}
+
+/**
+  * @brief Give every pending query its field of a response, in order.
+  */
+void GPIBQueryPipeline::complete(const QByteArray &response)
+{
+    int start = 0;
+    for( std::size_t i = 0; i < pending.size(); i++ ){
+        int end = response.indexOf( ';', start );
+        if( end < 0 ) end = response.size();
+
+        pending[i].set_value( response.mid( start, end - start ) );
+        start = qMin( end + 1, response.size() );
+    }
+    pending.clear();
+}
@@ -0,0 +1,46 @@
+#ifndef GPIBQUERYPIPELINE_H
+#define GPIBQUERYPIPELINE_H
+
+#include "./gpib/parallelCommunications/gpib/gpibPort.h"
+
+#include <QByteArray>
+
+#include <deque>
+#include <future>
+
+/**
+  * @brief Sends several queries in one program message and matches the responses.
+  *
+  * The queries are joined with ";" and written with a single ibwrt; the instrument
+  * queues the responses and sends them as one ";"-separated message, read with a
+  * single readAll. Every field is handed, in order, to the future returned by
+  * enqueue. A query that gets no field (e.g. after an error) gets an empty QByteArray.
+  * A query the instrument rejects sends no field at all, so the responses after it
+  * are shifted; only pipeline queries the instrument is known to accept.
+  *
+  *     GPIBQueryPipeline pipeline( port );
+  *     std::future<QByteArray> esr = pipeline.enqueue( "*ESR?" );
+  *     std::future<QByteArray> oer = pipeline.enqueue( ":STAT:OPER:EVEN?" );
+  *     pipeline.flush();
+  */
+class GPIBQueryPipeline
+{
+public:
+    GPIBQueryPipeline(GPIBPort *port);
+    ~GPIBQueryPipeline();
+
+    std::future<QByteArray> enqueue( const QByteArray &query );
+    int  flush();
+
+    int  count() const;
+    bool isEmpty() const;
+
+private:
+    void complete( const QByteArray &response );
+
+    GPIBPort  *port;
+    QByteArray message;
+    std::deque< std::promise<QByteArray> > pending;
+};
+
+#endif // GPIBQUERYPIPELINE_H
@@ -0,0 +1,144 @@
+#include "./gpib/parallelCommunications/gpib/gpibTrace.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+
+#include <cstring>
+
+/**
+  * Record of the ring. sequence is the index of the record plus one once it is
+  * complete, 0 while it is being written, so dump can skip torn records.
+  */
+struct GPIBTraceRecord
+{
+    std::atomic<quint64> sequence;
+    qint64  timestamp;
+    quint64 payload;
+    quint32 length;
+    quint32 captured;
+    qint32  ibsta;
+    quint16 address;
+    quint16 opcode;
+};
+
+std::atomic<bool> GPIBTrace::enabled( false );
+
+static GPIBTraceRecord records[GPIB_TRACE_RECORDS];
+static std::atomic<quint64> recordHead( 0 );
+static char arena[GPIB_TRACE_ARENA_SIZE];
+static std::atomic<quint64> arenaHead( 0 );
+
+static QElapsedTimer startedTimer()
+{
+    QElapsedTimer timer;
+    timer.start();
+    return timer;
+}
+
+/**
+  * Monotonic clock of the timestamps. Built on first use, so ports can be traced
+  * from static constructors.
+  */
+static const QElapsedTimer &traceClock()
+{
+    static const QElapsedTimer clock = startedTimer();
+    return clock;
+}
+
+/**
+  * @brief Turn tracing on or off. It is off by default.
+  */
+void GPIBTrace::setEnabled(bool state)
+{
+    traceClock();
+    enabled.store( state );
+}
+
+bool GPIBTrace::isEnabled() {return enabled.load( std::memory_order_relaxed );}
+
+/**
+  * @brief Add a record, copying up to GPIB_TRACE_MAX_PAYLOAD bytes of data to the arena.
+  */
+void GPIBTrace::append(int address, int opcode, int ibsta, const char *data, long length)
+{
+    quint64 index = recordHead.fetch_add( 1, std::memory_order_relaxed );
+    GPIBTraceRecord &record = records[ index & ( GPIB_TRACE_RECORDS - 1 ) ];
+
+    record.sequence.store( 0, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_release );
+
+    quint32 captured = 0;
+    if( data && length > 0 ){
+        captured = (quint32)qMin( length, (long)GPIB_TRACE_MAX_PAYLOAD );
+        quint64 position = arenaHead.fetch_add( captured, std::memory_order_relaxed );
+        quint32 offset = (quint32)( position & ( GPIB_TRACE_ARENA_SIZE - 1 ) );
+        quint32 first = qMin( captured, (quint32)GPIB_TRACE_ARENA_SIZE - offset );
+        memcpy( arena + offset, data, first );
+        memcpy( arena, data + first, captured - first );
+        record.payload = position;
+    }
+
+    record.timestamp = traceClock().nsecsElapsed();
+    record.length = length > 0 ? (quint32)length : 0;
+    record.captured = captured;
+    record.ibsta = ibsta;
+    record.address = (quint16)address;
+    record.opcode = (quint16)opcode;
+    record.sequence.store( index + 1, std::memory_order_release );
+}
+
+/**
+  * @brief Write the records in the ring to a file, oldest first.
+  *
+  * Can be called while other threads trace; the records being written are skipped.
+  *
+  * @param fileName Path of the file, overwritten.
+  * @return false if the file can not be written.
+  */
+bool GPIBTrace::dump(const QString &fileName)
+{
+    QFile file( fileName );
+    if( !file.open( QFile::WriteOnly | QFile::Truncate ) ) return false;
+    file.write( "GPIBTRC1", 8 );
+
+    quint64 head = recordHead.load( std::memory_order_acquire );
+    quint64 first = head > GPIB_TRACE_RECORDS ? head - GPIB_TRACE_RECORDS : 0;
+    char payload[GPIB_TRACE_MAX_PAYLOAD];
+
+    for( quint64 index = first; index < head; index++ ){
+        const GPIBTraceRecord &record = records[ index & ( GPIB_TRACE_RECORDS - 1 ) ];
+        if( record.sequence.load( std::memory_order_acquire ) != index + 1 ) continue;
+
+        qint64  timestamp = record.timestamp;
+        quint64 position = record.payload;
+        quint32 length = record.length;
+        quint32 captured = record.captured;
+        qint32  ibsta = record.ibsta;
+        quint16 address = record.address;
+        quint16 opcode = record.opcode;
+
+        if( captured > 0 ){
+            quint32 offset = (quint32)( position & ( GPIB_TRACE_ARENA_SIZE - 1 ) );
+            quint32 part = qMin( captured, (quint32)GPIB_TRACE_ARENA_SIZE - offset );
+            memcpy( payload, arena + offset, part );
+            memcpy( payload + part, arena, captured - part );
+        }
+
+        // Rewritten while it was copied
+        std::atomic_thread_fence( std::memory_order_acquire );
+        if( record.sequence.load( std::memory_order_relaxed ) != index + 1 ) continue;
+        // Payload overwritten by newer records
+        if( captured > 0 && arenaHead.load( std::memory_order_relaxed ) - position > GPIB_TRACE_ARENA_SIZE ) captured = 0;
+
+        file.write( (const char *)&timestamp, sizeof(timestamp) );
+        file.write( (const char *)&address, sizeof(address) );
+        file.write( (const char *)&opcode, sizeof(opcode) );
+        file.write( (const char *)&ibsta, sizeof(ibsta) );
+        file.write( (const char *)&length, sizeof(length) );
+        file.write( (const char *)&captured, sizeof(captured) );
+        if( captured > 0 ) file.write( payload, captured );
+    }
+
+    file.close();
+    return true;
+}
@@ -0,0 +1,80 @@
+#ifndef GPIBTRACE_H
+#define GPIBTRACE_H
+
+#include <QString>
+#include <QtGlobal>
+
+#include <atomic>
+
+/**
+  * Trace ring sizes
+  *  - GPIB_TRACE_RECORDS = records kept, the oldest are overwritten (power of 2)
+  *  - GPIB_TRACE_ARENA_SIZE = bytes of payload kept (power of 2)
+  *  - GPIB_TRACE_MAX_PAYLOAD = bytes of a write or read copied to the arena
+  */
+#define GPIB_TRACE_RECORDS 16384
+#define GPIB_TRACE_ARENA_SIZE ( 1 << 20 )
+#define GPIB_TRACE_MAX_PAYLOAD 256
+
+/**
+  * Traced operations. WRITE and READ carry the bytes sent or received as payload
+  * and their ibcnt as length; for the others length is the argument named here.
+  *  - OPEN = descriptor
+  *  - TIMEOUT = timeout code
+  *  - SRQ_WAIT = wait mask
+  *  - SERIAL_POLL = status byte
+  *  - CLEAR = 0
+  *  - ERROR = GPIBErrorCode
+  *  - RECOVER = GPIBErrorCode recovered from
+  */
+enum GPIBTraceOpcode
+{
+    GPIB_TRACE_WRITE = 1,
+    GPIB_TRACE_READ,
+    GPIB_TRACE_OPEN,
+    GPIB_TRACE_TIMEOUT,
+    GPIB_TRACE_SRQ_WAIT,
+    GPIB_TRACE_SERIAL_POLL,
+    GPIB_TRACE_CLEAR,
+    GPIB_TRACE_ERROR,
+    GPIB_TRACE_RECOVER
+};
+
+/**
+  * @brief Process wide binary trace of the bus operations.
+  *
+  * A fixed size ring of (timestamp, address, opcode, length, ibsta) records. The
+  * bytes written and read are copied to a payload arena and the record keeps their
+  * position. Writers never lock: a record costs two atomic increments and a copy.
+  * When tracing is off a trace point is a relaxed load and a branch, so it can be
+  * left in production and turned on at run time. dump writes the ring to a file
+  * after the fact.
+  *
+  * File format, native byte order: "GPIBTRC1", then for every record
+  * timestamp (qint64, ns), address (quint16), opcode (quint16), ibsta (qint32),
+  * length (quint32), payload size (quint32) and the payload bytes. The payload size
+  * is 0 when the bytes have been overwritten in the arena.
+  */
+class GPIBTrace
+{
+public:
+    static inline void event(int address, int opcode, int ibsta, long argument)
+    {
+        if( enabled.load( std::memory_order_relaxed ) ) append( address, opcode, ibsta, 0, argument );
+    }
+    static inline void transfer(int address, int opcode, int ibsta, const char *data, long length)
+    {
+        if( enabled.load( std::memory_order_relaxed ) ) append( address, opcode, ibsta, data, length );
+    }
+
+    static void setEnabled( bool state );
+    static bool isEnabled();
+    static bool dump( const QString &fileName );
+
+private:
+    static void append( int address, int opcode, int ibsta, const char *data, long length );
+
+    static std::atomic<bool> enabled;
+};
+
+#endif // GPIBTRACE_H
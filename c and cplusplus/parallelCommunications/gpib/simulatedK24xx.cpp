@@ -0,0 +1,872 @@
+#include "./gpib/parallelCommunications/gpib/simulatedK24xx.h"
+
+#include <QThread>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#define SIMULATED_READING_ELEMENTS 5    // VOLT, CURR, RES, TIME, STAT
+#define SIMULATED_OVERFLOW 9.91e37      // Value of the elements that are not measured
+#define SIMULATED_COMPLIANCE_BIT 0x08   // Bit of the STAT element
+#define SIMULATED_SETUPS 5              // Setup memories of *SAV and *RCL, 0 to 4
+
+#define ESR_OPERATION_COMPLETE 0x01
+#define ESR_COMMAND_ERROR 0x20
+
+#define STB_ERROR_AVAILABLE 0x04
+#define STB_MESSAGE_AVAILABLE 0x10
+#define STB_EVENT_SUMMARY 0x20
+#define STB_SERVICE_REQUEST 0x40
+
+// Milliseconds of the TNONE...T1000s timeout codes. TNONE is not simulated as infinite.
+static const double timeoutTable[] = {
+    1000000, 0.01, 0.03, 0.1, 0.3, 1, 3, 10, 30, 100, 300,
+    1000, 3000, 10000, 30000, 100000, 300000, 1000000
+};
+
+/**
+  * @brief Constructor
+  *
+  * @param address The primary address the instrument answers to.
+  */
+SimulatedK24xx::SimulatedK24xx(int address)
+{
+    this->address = address;
+    timeScale = 1;
+    load = SIMULATED_K24XX_LOAD;
+    injectedError = -1;
+    clock.start();
+    reset();
+}
+
+SimulatedK24xx::~SimulatedK24xx()
+{
+}
+
+/**
+  * @brief Resistance of the device under test connected to the output.
+  */
+void SimulatedK24xx::setLoadResistance(double ohms)
+{
+    QMutexLocker locker(&mutex);
+    load = ohms;
+}
+
+/**
+  * @brief Factor applied to the measurement times. 0 makes every measurement instantaneous.
+  */
+void SimulatedK24xx::setTimeScale(double scale)
+{
+    QMutexLocker locker(&mutex);
+    timeScale = scale;
+}
+
+/**
+  * @brief Make the next I/O call fail with an iberr code. EABO also reports TIMO.
+  */
+void SimulatedK24xx::injectError(int error)
+{
+    QMutexLocker locker(&mutex);
+    injectedError = error;
+}
+
+/**
+  * @brief Power-on state: *RST settings, status registers cleared and no pending output.
+  */
+void SimulatedK24xx::reset()
+{
+    QMutexLocker locker(&mutex);
+    output.clear();
+    responses.clear();
+    readingResponse = -1;
+    operationCompleteResponses.clear();
+    inputQueue.clear();
+    statusEnable = 0;
+    eventStatus = 0;
+    eventEnable = 0;
+    requestingService = false;
+    serviceSummary = false;
+    errorQueue.clear();
+    setDefaults();
+
+    savedSetups.clear();
+    for( int i = 0; i < SIMULATED_SETUPS; i++ ) savedSetups.append( settings );
+}
+
+/**
+  * @brief Settings after *RST.
+  */
+void SimulatedK24xx::setDefaults()
+{
+    settings.clear();
+    settings.insert("SOUR:FUNC", "VOLT");
+    settings.insert("SOUR:VOLT:MODE", "FIX");
+    settings.insert("SOUR:CURR:MODE", "FIX");
+    settings.insert("SOUR:VOLT:LEV", "0");
+    settings.insert("SOUR:CURR:LEV", "0");
+    settings.insert("SOUR:SWE:SPAC", "LIN");
+    settings.insert("SOUR:SWE:POIN", "2500");
+    settings.insert("SOUR:DEL", "0");
+    settings.insert("SENS:CURR:PROT", "1.05E-4");
+    settings.insert("SENS:VOLT:PROT", "21");
+    settings.insert("SENS:VOLT:NPLC", "1");
+    settings.insert("SENS:AVER:STAT", "OFF");
+    settings.insert("SENS:AVER:COUN", "10");
+    settings.insert("TRIG:COUN", "1");
+    settings.insert("TRIG:DEL", "0");
+    settings.insert("FORM:DATA", "ASC");
+    settings.insert("FORM:BORD", "NORM");
+    settings.insert("FORM:ELEM", "VOLT,CURR,RES,TIME,STAT");
+    settings.insert("OUTP:STAT", "OFF");
+    settings.insert("TRAC:POIN", "100");
+    settings.insert("TRAC:FEED:CONT", "NEV");
+    settings.insert("SYST:LFR", "50");
+
+    measuring = false;
+    operationCompletePending = false;
+    busyUntil = 0;
+    timerStart = now();
+    pending.clear();
+    latest.clear();
+    trace.clear();
+}
+
+//
+// Bus
+//
+
+GPIBStatus SimulatedK24xx::status(int ibsta, long count)
+{
+    GPIBStatus result;
+    result.ibsta = ibsta;
+    result.ibcnt = count;
+    return result;
+}
+
+GPIBStatus SimulatedK24xx::failure(int error)
+{
+    GPIBStatus result;
+    result.ibsta = ERR | CMPL;
+    if( error == EABO ) result.ibsta |= TIMO;
+    result.iberr = error;
+    return result;
+}
+
+bool SimulatedK24xx::takeInjectedError(GPIBStatus &result)
+{
+    if( injectedError < 0 ) return false;
+
+    result = failure( injectedError );
+    injectedError = -1;
+    return true;
+}
+
+/**
+  * @brief True if ud is an online device descriptor with the address of the instrument.
+  */
+bool SimulatedK24xx::isInstrument(int ud)
+{
+    int index = ud - 1;
+    if( index < 0 || index >= descriptors.size() ) return false;
+    return descriptors.at(index).online && descriptors.at(index).pad == address;
+}
+
+double SimulatedK24xx::timeoutOf(int ud)
+{
+    int index = ud - 1;
+    int timo = ( index >= 0 && index < descriptors.size() ) ? descriptors.at(index).timo : T10s;
+    if( timo < 0 || timo > T1000s ) timo = T10s;
+    return timeoutTable[timo];
+}
+
+/**
+  * @brief Milliseconds since the simulator was created.
+  */
+double SimulatedK24xx::now()
+{
+    return clock.nsecsElapsed() / 1e6;
+}
+
+/**
+  * @brief Sleep until a time. Must be called with the mutex unlocked.
+  */
+void SimulatedK24xx::sleepUntil(double time)
+{
+    double remaining = time - now();
+    if( remaining > 0 ) QThread::usleep( (unsigned long)( remaining * 1000 ) );
+}
+
+GPIBStatus SimulatedK24xx::ask(int ud, int option, int *value)
+{
+    Q_UNUSED(ud);
+    Q_UNUSED(option);
+    *value = 0;
+    return status( CMPL );
+}
+
+GPIBStatus SimulatedK24xx::config(int ud, int option, int value)
+{
+    Q_UNUSED(ud);
+    Q_UNUSED(option);
+    Q_UNUSED(value);
+    return status( CMPL );
+}
+
+GPIBStatus SimulatedK24xx::openDevice(int boardIndex, int pad, int sad, int timo, int eot, int eos, int &ud)
+{
+    Q_UNUSED(boardIndex);
+    Q_UNUSED(sad);
+    Q_UNUSED(eot);
+    Q_UNUSED(eos);
+    QMutexLocker locker(&mutex);
+
+    Descriptor descriptor;
+    descriptor.pad = pad;
+    descriptor.timo = timo;
+    descriptor.online = true;
+    descriptors.append( descriptor );
+
+    // 0 is the board
+    ud = descriptors.size();
+    return status( CMPL );
+}
+
+GPIBStatus SimulatedK24xx::online(int ud, int value)
+{
+    QMutexLocker locker(&mutex);
+    int index = ud - 1;
+    if( index >= 0 && index < descriptors.size() ) descriptors[index].online = ( value != 0 );
+    return status( CMPL );
+}
+
+/**
+  * @brief Selected Device Clear: the buffers are cleared and a measurement is aborted.
+  */
+GPIBStatus SimulatedK24xx::clear(int ud)
+{
+    QMutexLocker locker(&mutex);
+    GPIBStatus result;
+    if( takeInjectedError(result) ) return result;
+    if( !isInstrument(ud) ) return failure( ENOL );
+
+    output.clear();
+    responses.clear();
+    readingResponse = -1;
+    operationCompleteResponses.clear();
+    inputQueue.clear();
+    measuring = false;
+    operationCompletePending = false;
+    updateServiceRequest();
+    return status( CMPL );
+}
+
+GPIBStatus SimulatedK24xx::goToLocal(int ud)
+{
+    Q_UNUSED(ud);
+    return status( CMPL );
+}
+
+GPIBStatus SimulatedK24xx::findListener(int ud, int pad, int sad, short *listen)
+{
+    Q_UNUSED(ud);
+    Q_UNUSED(sad);
+    *listen = ( pad == address ) ? 1 : 0;
+    return status( CMPL );
+}
+
+GPIBStatus SimulatedK24xx::setPrimaryAddress(int ud, int pad)
+{
+    QMutexLocker locker(&mutex);
+    int index = ud - 1;
+    if( index >= 0 && index < descriptors.size() ) descriptors[index].pad = pad;
+    return status( CMPL );
+}
+
+GPIBStatus SimulatedK24xx::setSecondaryAddress(int ud, int sad)
+{
+    Q_UNUSED(ud);
+    Q_UNUSED(sad);
+    return status( CMPL );
+}
+
+GPIBStatus SimulatedK24xx::interfaceClear(int ud)
+{
+    Q_UNUSED(ud);
+    return status( CMPL | CIC );
+}
+
+GPIBStatus SimulatedK24xx::remoteEnable(int ud, int value)
+{
+    Q_UNUSED(ud);
+    Q_UNUSED(value);
+    return status( CMPL );
+}
+
+GPIBStatus SimulatedK24xx::setTimeout(int ud, int timo)
+{
+    QMutexLocker locker(&mutex);
+    int index = ud - 1;
+    if( index >= 0 && index < descriptors.size() ) descriptors[index].timo = timo;
+    return status( CMPL );
+}
+
+/**
+  * @brief Send a program message to the instrument.
+  *
+  * While a :READ? or *OPC? is waiting for a measurement the message is queued, as
+  * the instrument does not parse it until the measurement ends.
+  */
+GPIBStatus SimulatedK24xx::write(int ud, const char *data, long count)
+{
+    QMutexLocker locker(&mutex);
+    GPIBStatus result;
+    if( takeInjectedError(result) ) return result;
+    if( !isInstrument(ud) ) return failure( ENOL );
+
+    advance();
+    QString message = QString::fromLatin1( data, (int)count );
+    if( isSequentialPending() ) inputQueue.append( message );
+    else processMessage( message );
+    updateServiceRequest();
+    return status( CMPL, count );
+}
+
+/**
+  * @brief Read the output queue of the instrument.
+  *
+  * Waits for a pending :READ? or *OPC? within the timeout of the descriptor. END is
+  * reported with the last byte of the response.
+  */
+GPIBStatus SimulatedK24xx::read(int ud, char *buffer, long count)
+{
+    QMutexLocker locker(&mutex);
+    GPIBStatus result;
+    if( takeInjectedError(result) ) return result;
+    if( !isInstrument(ud) ) return failure( ENOL );
+
+    double deadline = now() + timeoutOf(ud);
+    advance();
+    while( output.isEmpty() ){
+        if( now() >= deadline ) return failure( EABO );
+
+        double until = isSequentialPending() ? qMin( busyUntil, deadline ) : deadline;
+        locker.unlock();
+        sleepUntil( until );
+        locker.relock();
+        advance();
+    }
+
+    long received = qMin( count, (long)output.size() );
+    memcpy( buffer, output.constData(), received );
+    output = output.mid( (int)received );
+
+    updateServiceRequest();
+    return status( output.isEmpty() ? CMPL | END : CMPL, received );
+}
+
+/**
+  * @brief Wait for RQS of the instrument (or CMPL, always set) within the timeout.
+  */
+GPIBStatus SimulatedK24xx::wait(int ud, int mask)
+{
+    QMutexLocker locker(&mutex);
+    GPIBStatus result;
+    if( takeInjectedError(result) ) return result;
+    if( !isInstrument(ud) ) return failure( ENOL );
+
+    double deadline = now() + timeoutOf(ud);
+    for( ;; ){
+        advance();
+        int state = CMPL;
+        if( requestingService ) state |= RQS;
+        if( ( state & mask & ~TIMO ) != 0 ) return status( state );
+        if( now() >= deadline ) return status( state | TIMO );
+
+        double until = measuring ? qMin( busyUntil, deadline ) : deadline;
+        locker.unlock();
+        sleepUntil( until );
+        locker.relock();
+    }
+}
+
+/**
+  * @brief Serial poll: the Status Byte with RQS in bit 6. Clears the service request.
+  */
+GPIBStatus SimulatedK24xx::serialPoll(int ud, char *spr)
+{
+    QMutexLocker locker(&mutex);
+    GPIBStatus result;
+    if( takeInjectedError(result) ) return result;
+    if( !isInstrument(ud) ) return failure( ENOL );
+
+    advance();
+    int stb = statusByte() & ~STB_SERVICE_REQUEST;
+    if( requestingService ) stb |= STB_SERVICE_REQUEST;
+    requestingService = false;
+
+    *spr = (char)stb;
+    return status( CMPL );
+}
+
+/**
+  * @brief The transfer is done at once, notify reports it.
+  */
+GPIBStatus SimulatedK24xx::writeAsync(int ud, const char *data, long count)
+{
+    asyncStatus = write( ud, data, count );
+    return asyncStatus;
+}
+
+GPIBStatus SimulatedK24xx::readAsync(int ud, char *buffer, long count)
+{
+    asyncStatus = read( ud, buffer, count );
+    return asyncStatus;
+}
+
+GPIBStatus SimulatedK24xx::notify(int ud, int mask, GpibNotifyReceiver *receiver)
+{
+    Q_UNUSED(mask);
+    if( receiver ) receiver->gpibNotify( ud, asyncStatus.ibsta, asyncStatus.iberr, asyncStatus.ibcnt );
+    return status( CMPL );
+}
+
+GPIBStatus SimulatedK24xx::stop(int ud)
+{
+    Q_UNUSED(ud);
+    return status( CMPL );
+}
+
+//
+// Status reporting
+//
+
+/**
+  * @brief Bring the instrument up to the current time: end the measurement if it is done.
+  */
+void SimulatedK24xx::advance()
+{
+    if( measuring && now() >= busyUntil ) completeMeasurement();
+    updateServiceRequest();
+}
+
+/**
+  * @brief Request service on a rising edge of the summary of the enabled Status Byte bits.
+  */
+void SimulatedK24xx::updateServiceRequest()
+{
+    bool summary = ( statusByte() & statusEnable & ~STB_SERVICE_REQUEST ) != 0;
+    if( summary && !serviceSummary ) requestingService = true;
+    serviceSummary = summary;
+}
+
+int SimulatedK24xx::statusByte()
+{
+    int stb = 0;
+    if( !errorQueue.isEmpty() ) stb |= STB_ERROR_AVAILABLE;
+    if( !output.isEmpty() ) stb |= STB_MESSAGE_AVAILABLE;
+    if( eventStatus & eventEnable ) stb |= STB_EVENT_SUMMARY;
+    if( stb & statusEnable ) stb |= STB_SERVICE_REQUEST;
+    return stb;
+}
+
+//
+// Parser
+//
+
+/**
+  * @brief Execute the commands of a message. The responses of its queries are joined with ";".
+  */
+void SimulatedK24xx::processMessage(const QString &message)
+{
+    QStringList commands = splitMessage( message );
+    for( int i = 0; i < commands.size(); i++ ) execute( commands.at(i) );
+    if( !isSequentialPending() ) flushResponses();
+}
+
+void SimulatedK24xx::flushResponses()
+{
+    if( responses.isEmpty() ) return;
+
+    QByteArray message;
+    for( int i = 0; i < responses.size(); i++ ){
+        if( i > 0 ) message.append( ';' );
+        message.append( responses.at(i) );
+    }
+    message.append( '\n' );
+    output.append( message );
+    responses.clear();
+}
+
+/**
+  * @brief True while a :READ? or *OPC? waits for the end of the measurement.
+  */
+bool SimulatedK24xx::isSequentialPending()
+{
+    return measuring && ( readingResponse >= 0 || !operationCompleteResponses.isEmpty() );
+}
+
+void SimulatedK24xx::respond(const QByteArray &response)
+{
+    responses.append( response );
+}
+
+void SimulatedK24xx::commandError(const QString &command)
+{
+    Q_UNUSED(command);
+    errorQueue.append( "-113,\"Undefined header\"" );
+    eventStatus |= ESR_COMMAND_ERROR;
+}
+
+bool SimulatedK24xx::isOn(const QString &header)
+{
+    QString value = settings.value( header ).toUpper();
+    return value == "ON" || value == "1";
+}
+
+void SimulatedK24xx::execute(const QString &command)
+{
+    QString unit = command.trimmed();
+    int space = unit.indexOf( ' ' );
+    QString header = ( space < 0 ) ? unit : unit.left( space );
+    QString value = ( space < 0 ) ? QString() : unit.mid( space + 1 ).trimmed();
+
+    bool query = header.endsWith( '?' );
+    if( query ) header.chop( 1 );
+    header = header.toUpper();
+
+    if( header.startsWith( '*' ) ){
+        if( header == "*RST" ) setDefaults();
+        else if( header == "*CLS" ){ eventStatus = 0; errorQueue.clear(); }
+        else if( header == "*WAI" ) {}
+        else if( header == "*OPC" && !query ){
+            if( measuring ) operationCompletePending = true;
+            else eventStatus |= ESR_OPERATION_COMPLETE;
+        }
+        else if( header == "*OPC" ){
+            if( measuring ){
+                operationCompleteResponses.append( responses.size() );
+                respond( QByteArray() );
+            } else {
+                respond( "1" );
+            }
+        }
+        else if( header == "*ESE" && !query ) eventEnable = value.toInt() & 0xFF;
+        else if( header == "*SRE" && !query ) statusEnable = value.toInt() & 0xFF & ~STB_SERVICE_REQUEST;
+        else if( header == "*ESE" ) respond( QByteArray::number( eventEnable ) );
+        else if( header == "*SRE" ) respond( QByteArray::number( statusEnable ) );
+        else if( header == "*ESR" ){ respond( QByteArray::number( eventStatus ) ); eventStatus = 0; }
+        else if( header == "*STB" ) respond( QByteArray::number( statusByte() ) );
+        else if( header == "*IDN" ) respond( "KEITHLEY INSTRUMENTS INC.,MODEL 2400,0000000,SIMULATED" );
+        else if( header == "*TRG" ) startMeasurement( false );
+        else if( ( header == "*SAV" || header == "*RCL" ) && !query ){
+            bool valid = false;
+            int setup = value.toInt( &valid );
+            if( !valid || setup < 0 || setup >= SIMULATED_SETUPS ) commandError( unit );
+            else if( header == "*SAV" ) savedSetups[setup] = settings;
+            else settings = savedSetups.at( setup );
+        }
+        else commandError( unit );
+        return;
+    }
+
+    QString key = normalize( header );
+    if( query ){
+        executeQuery( key );
+        return;
+    }
+
+    if( key == "INIT" ){
+        if( measuring ) errorQueue.append( "-213,\"Init ignored\"" );
+        else startMeasurement( false );
+    }
+    else if( key == "ABOR" ) measuring = false;
+    else if( key == "TRAC:CLE" ) trace.clear();
+    else if( key == "TRIG:CLE" ) {}
+    else if( key == "SYST:TIME:RES" ) timerStart = now();
+    else if( key == "SYST:PRES" ) setDefaults();
+    else if( value.isEmpty() || !isSubsystem( key ) ) commandError( unit );
+    else settings.insert( key, value );
+}
+
+void SimulatedK24xx::executeQuery(const QString &header)
+{
+    if( header == "READ" ){
+        if( measuring ) errorQueue.append( "-213,\"Init ignored\"" );
+        else startMeasurement( true );
+    }
+    else if( header == "FETC" ) respond( format( latest ) );
+    else if( header == "TRAC:DATA" ) respond( format( trace ) );
+    else if( header == "TRAC:POIN:ACT" ) respond( QByteArray::number( trace.size() / SIMULATED_READING_ELEMENTS ) );
+    else if( header == "SYST:ERR" || header == "STAT:QUE" )
+        respond( errorQueue.isEmpty() ? QByteArray( "0,\"No error\"" ) : errorQueue.takeFirst().toLatin1() );
+    else if( header == "STAT:OPER:EVEN" || header == "STAT:MEAS:EVEN" || header == "STAT:QUES:EVEN" )
+        respond( "0" );
+    else if( settings.contains( header ) ) respond( settings.value( header ).toLatin1() );
+    else commandError( header + "?" );
+}
+
+/**
+  * @brief True if a header belongs to one of the subsystems of the instrument.
+  */
+bool SimulatedK24xx::isSubsystem(const QString &header)
+{
+    static const char *subsystems[] = { "SOUR", "SENS", "FORM", "TRIG", "ARM", "OUTP", "TRAC",
+                                        "SYST", "CALC", "STAT", "DISP", "ROUT" };
+    QString root = header.left( header.indexOf( ':' ) < 0 ? header.size() : header.indexOf( ':' ) );
+    for( unsigned i = 0; i < sizeof(subsystems) / sizeof(subsystems[0]); i++ )
+        if( root == subsystems[i] ) return true;
+    return false;
+}
+
+/**
+  * @brief Short form of a header: upper case, without the leading ":" and with
+  * every node cut as SCPI does (e.g. ":SOURce:VOLTage:LEVel" -> "SOUR:VOLT:LEV").
+  */
+QString SimulatedK24xx::normalize(const QString &header)
+{
+    QString text = header.toUpper();
+    if( text.startsWith( ':' ) ) text = text.mid( 1 );
+
+    QStringList nodes = text.split( ':' );
+    QString key;
+    for( int i = 0; i < nodes.size(); i++ ){
+        QString node = nodes.at(i);
+        int letters = 0;
+        while( letters < node.size() && node.at(letters).toLatin1() >= 'A' && node.at(letters).toLatin1() <= 'Z' ) letters++;
+        QString suffix = node.mid( letters );
+        if( letters > 4 ){
+            char fourth = node.at(3).toLatin1();
+            bool vowel = fourth == 'A' || fourth == 'E' || fourth == 'I' || fourth == 'O' || fourth == 'U';
+            node = node.left( vowel ? 3 : 4 ) + suffix;
+        }
+        if( i > 0 ) key.append( ':' );
+        key.append( node );
+    }
+
+    // Optional nodes
+    if( key == "OUTP" ) return "OUTP:STAT";
+    if( key == "SOUR:VOLT" || key == "SOUR:VOLT:LEV:IMM" || key == "SOUR:VOLT:LEV:IMM:AMPL" ) return "SOUR:VOLT:LEV";
+    if( key == "SOUR:CURR" || key == "SOUR:CURR:LEV:IMM" || key == "SOUR:CURR:LEV:IMM:AMPL" ) return "SOUR:CURR:LEV";
+    if( key == "INIT:IMM" ) return "INIT";
+    return key;
+}
+
+/**
+  * @brief Split a program message in commands at ";" and new lines outside quotes.
+  */
+QStringList SimulatedK24xx::splitMessage(const QString &message)
+{
+    QStringList commands;
+    QString current;
+    char quote = 0;
+    for( int i = 0; i < message.size(); i++ ){
+        char c = message.at(i).toLatin1();
+        if( quote ){
+            if( c == quote ) quote = 0;
+        } else if( c == '"' || c == '\'' ){
+            quote = c;
+        } else if( c == ';' || c == '\n' || c == '\r' ){
+            if( !current.trimmed().isEmpty() ) commands.append( current.trimmed() );
+            current.clear();
+            continue;
+        }
+        current.append( message.at(i) );
+    }
+    if( !current.trimmed().isEmpty() ) commands.append( current.trimmed() );
+    return commands;
+}
+
+//
+// Measurement model
+//
+
+/**
+  * @brief Milliseconds of one reading: NPLC x line cycle x 3 (auto zero) x filter count + source delay.
+  */
+double SimulatedK24xx::readingTime()
+{
+    static const char *nplcHeaders[] = { "SENS:VOLT:NPLC", "SENS:CURR:NPLC", "SENS:RES:NPLC" };
+    double nplc = 0;
+    for( int i = 0; i < 3; i++ ) nplc = qMax( nplc, settings.value( nplcHeaders[i] ).toDouble() );
+    if( nplc <= 0 ) nplc = 1;
+
+    double lineFrequency = settings.value( "SYST:LFR" ).toDouble();
+    if( lineFrequency <= 0 ) lineFrequency = 50;
+
+    int filterCount = 1;
+    if( isOn( "SENS:AVER:STAT" ) ) filterCount = qMax( 1, settings.value( "SENS:AVER:COUN" ).toInt() );
+
+    double delay = qMax( 0.0, settings.value( "SOUR:DEL" ).toDouble() ) * 1000;
+    return nplc * ( 1000 / lineFrequency ) * 3 * filterCount + delay;
+}
+
+/**
+  * @brief Source level of a point of the trigger model: fixed level or sweep point.
+  */
+double SimulatedK24xx::sourceLevel(int point)
+{
+    QString function = settings.value( "SOUR:FUNC" ).toUpper().startsWith( "CURR" ) ? "CURR" : "VOLT";
+    if( !settings.value( "SOUR:" + function + ":MODE" ).toUpper().startsWith( "SWE" ) )
+        return settings.value( "SOUR:" + function + ":LEV" ).toDouble();
+
+    double start = settings.value( "SOUR:" + function + ":STAR" ).toDouble();
+    double stop = settings.value( "SOUR:" + function + ":STOP" ).toDouble();
+    int points = qMax( 2, settings.value( "TRIG:COUN" ).toInt() );
+
+    if( settings.value( "SOUR:SWE:SPAC" ).toUpper().startsWith( "LOG" ) && start > 0 && stop > 0 )
+        return start * pow( stop / start, (double)point / ( points - 1 ) );
+
+    double step = settings.value( "SOUR:" + function + ":STEP" ).toDouble();
+    if( step == 0 ) step = ( stop - start ) / ( points - 1 );
+    double level = start + point * step;
+    return ( step > 0 ) ? qMin( level, stop ) : qMax( level, stop );
+}
+
+/**
+  * @brief Reading of the resistive load for a source level, limited by the compliance.
+  *
+  * @param reading Set to VOLT, CURR, RES and STAT (TIME is set by the caller).
+  */
+void SimulatedK24xx::measure(double level, double *reading)
+{
+    bool currentSource = settings.value( "SOUR:FUNC" ).toUpper().startsWith( "CURR" );
+    double voltage, current;
+    int state = 0;
+
+    if( currentSource ){
+        double compliance = fabs( settings.value( "SENS:VOLT:PROT" ).toDouble() );
+        current = level;
+        voltage = current * load;
+        if( fabs(voltage) > compliance ){
+            voltage = ( voltage < 0 ) ? -compliance : compliance;
+            state |= SIMULATED_COMPLIANCE_BIT;
+        }
+    } else {
+        double compliance = fabs( settings.value( "SENS:CURR:PROT" ).toDouble() );
+        voltage = level;
+        current = voltage / load;
+        if( fabs(current) > compliance ){
+            current = ( current < 0 ) ? -compliance : compliance;
+            voltage = current * load;
+            state |= SIMULATED_COMPLIANCE_BIT;
+        }
+    }
+
+    reading[0] = voltage;
+    reading[1] = current;
+    reading[2] = ( current != 0 ) ? voltage / current : SIMULATED_OVERFLOW;
+    reading[4] = state;
+}
+
+/**
+  * @brief Start the readings of one trigger count. They are ready after their measurement time.
+  *
+  * @param query True for :READ?, whose response is sent when the readings are ready.
+  */
+void SimulatedK24xx::startMeasurement(bool query)
+{
+    int count = qMax( 1, settings.value( "TRIG:COUN" ).toInt() );
+    double reading = readingTime();
+    double start = now();
+
+    pending.resize( count * SIMULATED_READING_ELEMENTS );
+    for( int i = 0; i < count; i++ ){
+        double *values = pending.data() + i * SIMULATED_READING_ELEMENTS;
+        measure( sourceLevel(i), values );
+        values[3] = ( start - timerStart ) / 1000 + ( i + 1 ) * reading / 1000;
+    }
+
+    measuring = true;
+    busyUntil = start + count * reading * timeScale;
+    if( query ){
+        readingResponse = responses.size();
+        respond( QByteArray() );
+    }
+}
+
+/**
+  * @brief The readings are ready: fill the buffer of readings, *OPC and the pending responses.
+  */
+void SimulatedK24xx::completeMeasurement()
+{
+    measuring = false;
+    latest = pending;
+
+    if( settings.value( "TRAC:FEED:CONT" ).toUpper().startsWith( "NEXT" ) ){
+        int capacity = settings.value( "TRAC:POIN" ).toInt() * SIMULATED_READING_ELEMENTS;
+        for( int i = 0; i < latest.size() && trace.size() < capacity; i++ ) trace.append( latest.at(i) );
+        if( trace.size() >= capacity ) settings.insert( "TRAC:FEED:CONT", "NEV" );
+    }
+
+    if( operationCompletePending ){
+        eventStatus |= ESR_OPERATION_COMPLETE;
+        operationCompletePending = false;
+    }
+
+    if( readingResponse >= 0 ) responses[readingResponse] = format( latest );
+    for( int i = 0; i < operationCompleteResponses.size(); i++ )
+        responses[ operationCompleteResponses.at(i) ] = "1";
+    readingResponse = -1;
+    operationCompleteResponses.clear();
+    flushResponses();
+
+    // Messages received during the measurement
+    while( !inputQueue.isEmpty() && !isSequentialPending() )
+        processMessage( inputQueue.takeFirst() );
+}
+
+/**
+  * @brief Format readings as :FORM:ELEM, :FORM:DATA and :FORM:BORD say.
+  *
+  * @param values Readings of SIMULATED_READING_ELEMENTS values each.
+  */
+QByteArray SimulatedK24xx::format(const QVector<double> &values)
+{
+    static const char *elementNames[SIMULATED_READING_ELEMENTS] = { "VOLT", "CURR", "RES", "TIME", "STAT" };
+    QString elements = settings.value( "FORM:ELEM" ).toUpper();
+    bool selected[SIMULATED_READING_ELEMENTS];
+    for( int e = 0; e < SIMULATED_READING_ELEMENTS; e++ ) selected[e] = elements.contains( elementNames[e] );
+
+    QString dataFormat = settings.value( "FORM:DATA" ).toUpper();
+    bool binary = dataFormat.startsWith( "REAL" ) || dataFormat.startsWith( "SRE" );
+    bool single = dataFormat.startsWith( "SRE" ) || dataFormat.contains( "32" );
+    bool littleEndian = settings.value( "FORM:BORD" ).toUpper().startsWith( "SW" );
+
+    const unsigned short probe = 1;
+    const bool reverse = ( *reinterpret_cast<const unsigned char *>(&probe) == 1 ) != littleEndian;
+
+    QByteArray result;
+    if( binary ) result.append( "#0" );
+    char text[32];
+    unsigned char bytes[8];
+    int readings = values.size() / SIMULATED_READING_ELEMENTS;
+    for( int r = 0; r < readings; r++ ){
+        for( int e = 0; e < SIMULATED_READING_ELEMENTS; e++ ){
+            if( !selected[e] ) continue;
+            double value = values.at( r * SIMULATED_READING_ELEMENTS + e );
+
+            if( binary ){
+                int size = single ? 4 : 8;
+                if( single ){
+                    float f = (float)value;
+                    memcpy( bytes, &f, 4 );
+                } else {
+                    memcpy( bytes, &value, 8 );
+                }
+                if( reverse )
+                    for( int b = 0; b < size / 2; b++ ){
+                        unsigned char t = bytes[b];
+                        bytes[b] = bytes[size - 1 - b];
+                        bytes[size - 1 - b] = t;
+                    }
+                result.append( (const char *)bytes, size );
+            } else {
+                if( !result.isEmpty() ) result.append( ',' );
+                snprintf( text, sizeof(text), "%+.6E", value );
+                result.append( text );
+            }
+        }
+    }
+    return result;
+}
@@ -0,0 +1,139 @@
+#ifndef SIMULATEDK24XX_H
+#define SIMULATEDK24XX_H
+
+#include "./gpib/parallelCommunications/gpib/gpibDriver.h"
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+/**
+  * Default primary address and load of the simulated SourceMeter
+  */
+#define SIMULATED_K24XX_ADDRESS 24
+#define SIMULATED_K24XX_LOAD    1000.0
+
+/**
+  * @brief In process Keithley 24xx SourceMeter, seen through the GPIBDriver interface.
+  *
+  * It parses the commands built by SCPICommandFactory, keeps the source, measure,
+  * format, trigger and trace settings, and answers :READ?, :FETC?, :TRAC:DATA?,
+  * the IEEE 488.2 common queries and any setting query. The device under test is
+  * a resistor. Every reading takes NPLC x line cycle x 3 (auto zero) x filter count,
+  * so the timing of the host code can be measured; setTimeScale speeds it up. The
+  * Status Byte, its enable register and *OPC work as in the instrument, so SRQ can
+  * be waited for with wait() and serialPoll(). *SAV and *RCL keep five setups.
+  * injectError makes the next call fail.
+  */
+class SimulatedK24xx: public GPIBDriver
+{
+public:
+    SimulatedK24xx( int address = SIMULATED_K24XX_ADDRESS );
+    ~SimulatedK24xx();
+
+    void setLoadResistance( double ohms );
+    void setTimeScale( double scale );
+    void injectError( int error );
+    void reset();
+
+    GPIBStatus ask( int ud, int option, int *value );
+    GPIBStatus config( int ud, int option, int value );
+    GPIBStatus openDevice( int boardIndex, int pad, int sad, int timo, int eot, int eos, int &ud );
+    GPIBStatus online( int ud, int value );
+    GPIBStatus clear( int ud );
+    GPIBStatus goToLocal( int ud );
+    GPIBStatus findListener( int ud, int pad, int sad, short *listen );
+    GPIBStatus setPrimaryAddress( int ud, int pad );
+    GPIBStatus setSecondaryAddress( int ud, int sad );
+    GPIBStatus interfaceClear( int ud );
+    GPIBStatus remoteEnable( int ud, int value );
+    GPIBStatus setTimeout( int ud, int timo );
+    GPIBStatus write( int ud, const char *data, long count );
+    GPIBStatus read( int ud, char *buffer, long count );
+    GPIBStatus wait( int ud, int mask );
+    GPIBStatus serialPoll( int ud, char *spr );
+    GPIBStatus writeAsync( int ud, const char *data, long count );
+    GPIBStatus readAsync( int ud, char *buffer, long count );
+    GPIBStatus notify( int ud, int mask, GpibNotifyReceiver *receiver );
+    GPIBStatus stop( int ud );
+
+private:
+    struct Descriptor
+    {
+        int pad;
+        int timo;
+        bool online;
+    };
+
+    GPIBStatus status( int ibsta, long count = 0 );
+    GPIBStatus failure( int error );
+    bool       takeInjectedError( GPIBStatus &result );
+    bool       isInstrument( int ud );
+    double     timeoutOf( int ud );
+    double     now();
+    void       sleepUntil( double time );
+
+    void       advance();
+    void       updateServiceRequest();
+    int        statusByte();
+
+    void       processMessage( const QString &message );
+    void       flushResponses();
+    bool       isSequentialPending();
+    void       execute( const QString &command );
+    void       executeQuery( const QString &header );
+    void       setDefaults();
+    void       startMeasurement( bool query );
+    void       completeMeasurement();
+    double     readingTime();
+    double     sourceLevel( int point );
+    void       measure( double level, double *reading );
+    QByteArray format( const QVector<double> &values );
+    void       respond( const QByteArray &response );
+    bool       isOn( const QString &header );
+    void       commandError( const QString &command );
+
+    static bool isSubsystem( const QString &header );
+    static QString normalize( const QString &header );
+    static QStringList splitMessage( const QString &message );
+
+    QMutex      mutex;
+    QElapsedTimer clock;
+    double      timeScale;
+    double      load;
+    int         address;
+    int         injectedError;
+
+    QList<Descriptor> descriptors;
+    QHash<QString, QString> settings;
+    QList< QHash<QString, QString> > savedSetups;
+
+    QByteArray  output;
+    QList<QByteArray> responses;
+    int         readingResponse;
+    QList<int>  operationCompleteResponses;
+    QStringList inputQueue;
+    int         statusEnable;
+    int         eventStatus;
+    int         eventEnable;
+    bool        requestingService;
+    bool        serviceSummary;
+    QStringList errorQueue;
+
+    bool        measuring;
+    bool        operationCompletePending;
+    double      busyUntil;
+    double      timerStart;
+    QVector<double> pending;
+    QVector<double> latest;
+    QVector<double> trace;
+
+    GPIBStatus  asyncStatus;
+};
+
+#endif // SIMULATEDK24XX_H
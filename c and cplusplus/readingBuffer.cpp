@@ -0,0 +1,211 @@
+#include "../GPIB/readingBuffer.h"
+
+#include "./gpib/scpiNumericParser.h"
+
+// The instrument sends the elements in this order, whatever the :FORM:ELEM order
+static const char *elementOrder[READING_MAX_ELEMENTS] = { "VOLT", "CURR", "RES", "TIME", "STAT" };
+
+ReadingBuffer::ReadingBuffer()
+{
+    readings = 0;
+    reserved = 0;
+}
+
+/**
+  * @brief Constructor
+  *
+  * @param elements The element list sent with :FORM:ELEM, e.g. "VOLT,CURR".
+  * @param capacity Number of readings to reserve, usually the :TRAC:POIN size.
+  */
+ReadingBuffer::ReadingBuffer(const QString &elements, int capacity)
+{
+    readings = 0;
+    reserved = 0;
+    setElements(elements);
+    reserve(capacity);
+}
+
+ReadingBuffer::~ReadingBuffer()
+{
+}
+
+/**
+  * @brief Set the active element list. The buffer is emptied.
+  *
+  * @param elements The element list sent with :FORM:ELEM, e.g. "CURR,VOLT,TIME".
+  */
+void ReadingBuffer::setElements(const QString &elements)
+{
+    QString requested = elements.toUpper();
+
+    names.clear();
+    for( int i = 0; i < READING_MAX_ELEMENTS; i++ )
+        if( requested.contains( elementOrder[i] ) ) names.append( elementOrder[i] );
+
+    columns.clear();
+    columns.resize( names.size() );
+    for( int e = 0; e < columns.size(); e++ ) columns[e].resize( reserved );
+    readings = 0;
+}
+
+/**
+  * @brief The active elements in the order the instrument sends them.
+  */
+QStringList ReadingBuffer::elements() const
+{
+    return names;
+}
+
+int ReadingBuffer::elementCount() const
+{
+    return names.size();
+}
+
+/**
+  * @brief Column index of an element, -1 if it is not active.
+  */
+int ReadingBuffer::elementIndex(const QString &element) const
+{
+    return names.indexOf( element.toUpper() );
+}
+
+/**
+  * @brief Allocate room for a number of readings.
+  *
+  * Call it with the same size given to setBufferOfReadingsSize before the readings
+  * are fetched. It never shrinks the buffer.
+  *
+  * @param readings Number of readings.
+  */
+void ReadingBuffer::reserve(int readings)
+{
+    if( readings <= reserved ) return;
+
+    reserved = readings;
+    for( int e = 0; e < columns.size(); e++ ) columns[e].resize( reserved );
+}
+
+int ReadingBuffer::capacity() const
+{
+    return reserved;
+}
+
+/**
+  * @brief Number of complete readings stored.
+  */
+int ReadingBuffer::size() const
+{
+    return readings;
+}
+
+bool ReadingBuffer::isEmpty() const
+{
+    return readings == 0;
+}
+
+/**
+  * @brief Remove the readings, keeping the elements and the reserved capacity.
+  */
+void ReadingBuffer::clear()
+{
+    readings = 0;
+}
+
+/**
+  * @brief Append one reading.
+  *
+  * @param reading elementCount() values in the order of elements().
+  */
+void ReadingBuffer::append(const double *reading)
+{
+    if( readings == reserved ) reserve( reserved > 0 ? reserved * 2 : 16 );
+
+    for( int e = 0; e < columns.size(); e++ ) columns[e][readings] = reading[e];
+    readings++;
+}
+
+/**
+  * @brief Append interleaved readings as returned by :READ?, :FETC? or :TRAC:DATA?.
+  *
+  * @param values The values, elementCount() per reading.
+  * @param count Number of values. A trailing partial reading is ignored.
+  * @return The number of readings appended.
+  */
+int ReadingBuffer::appendInterleaved(const double *values, int count)
+{
+    int elementCount = columns.size();
+    if( elementCount == 0 ) return 0;
+
+    int added = count / elementCount;
+    reserve( readings + added );
+
+    for( int e = 0; e < elementCount; e++ ){
+        double *destination = columns[e].data() + readings;
+        const double *source = values + e;
+        for( int r = 0; r < added; r++ ) destination[r] = source[r * elementCount];
+    }
+    readings += added;
+    return added;
+}
+
+/**
+  * @brief Parse an ASCII response straight into the columns.
+  *
+  * @param data The response, it does not need to be NUL terminated.
+  * @param length The number of bytes of data.
+  * @return The number of readings appended.
+  */
+int ReadingBuffer::appendAscii(const char *data, int length)
+{
+    int elementCount = columns.size();
+    if( elementCount == 0 ) return 0;
+
+    // Grow only if the response holds more readings than the room left: one field
+    // per separator plus the last one
+    int fields = 1;
+    for( int i = 0; i < length; i++ )
+        if( data[i] == ',' || data[i] == ';' ) fields++;
+    reserve( readings + fields / elementCount );
+
+    double *destinations[READING_MAX_ELEMENTS];
+    for( int e = 0; e < elementCount; e++ ) destinations[e] = columns[e].data() + readings;
+
+    int added = ScpiNumericParser::parseColumns( data, length, elementCount,
+                                                 destinations, reserved - readings );
+    readings += added;
+    return added;
+}
+
+/**
+  * @brief Contiguous values of an element, size() of them.
+  *
+  * @param element Column index, see elementIndex.
+  * @return The first value, or 0 if the element is not active.
+  */
+const double *ReadingBuffer::column(int element) const
+{
+    if( element < 0 || element >= columns.size() ) return 0;
+    return columns.at(element).constData();
+}
+
+/**
+  * @brief Contiguous values of an element by name, e.g. column("CURR").
+  */
+const double *ReadingBuffer::column(const QString &element) const
+{
+    return column( elementIndex(element) );
+}
+
+/**
+  * @brief Copy of the values of an element.
+  */
+QVector<double> ReadingBuffer::columnVector(int element) const
+{
+    if( element < 0 || element >= columns.size() ) return QVector<double>();
+    return columns.at(element).mid( 0, readings );
+}
+
+double ReadingBuffer::value(int reading, int element) const
+{
+    return columns.at(element).at(reading);
+}
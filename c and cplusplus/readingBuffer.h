@@ -0,0 +1,55 @@
+#ifndef READINGBUFFER_H
+#define READINGBUFFER_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+/**
+  * Maximum number of elements of a reading (VOLT, CURR, RES, TIME, STAT)
+  */
+#define READING_MAX_ELEMENTS 5
+
+/**
+  * @brief Readings stored as one contiguous column per :FORM:ELEM element.
+  *
+  * The instrument interleaves the elements of every reading. The buffer keeps them
+  * de-interleaved, so a consumer can go through the currents alone without striding
+  * over the voltages. Columns are allocated with reserve(); appends within the
+  * reserved capacity never reallocate, so pointers returned by column() stay valid.
+  */
+class ReadingBuffer
+{
+public:
+    ReadingBuffer();
+    ReadingBuffer(const QString &elements, int capacity = 0);
+    ~ReadingBuffer();
+
+    void setElements(const QString &elements);
+    QStringList elements() const;
+    int  elementCount() const;
+    int  elementIndex(const QString &element) const;
+
+    void reserve(int readings);
+    int  capacity() const;
+    int  size() const;
+    bool isEmpty() const;
+    void clear();
+
+    void append(const double *reading);
+    int  appendInterleaved(const double *values, int count);
+    int  appendAscii(const char *data, int length);
+
+    const double *column(int element) const;
+    const double *column(const QString &element) const;
+    QVector<double> columnVector(int element) const;
+    double value(int reading, int element) const;
+
+private:
+    QStringList names;
+    QVector< QVector<double> > columns;
+    int readings;
+    int reserved;
+};
+
+#endif // READINGBUFFER_H
@@ -16,20 +16,36 @@
 #include "./instruments/keithley/sourceMeters/K24xxConfigurationParameters.h"
 
 /**
-  * @brief Constructor
+  * @brief Constructor. The Scpi object owns its own Gpib device.
   */
 Scpi::Scpi()
 {
+    gpib = new Gpib(this);
+}
+
+/**
+  * @brief Constructor
+  *
+  * @param device The Gpib device the commands are sent to. Several Scpi objects
+  * can drive several instruments from the same process.
+  */
+Scpi::Scpi(Gpib *device)
+{
+    gpib = device;
 }
 
 Scpi::~Scpi()
 {
 }
 
+Gpib *Scpi::getGpib()
+{
+    return gpib;
+}
+
 void Scpi::write(QString _message){
-    qDebug() << _message.toLocal8Bit().data();
-    if(Gpib::isNoError()){
-        Gpib::write( _message.toLocal8Bit().data() );
+    if(gpib->isNoError()){
+        gpib->write( _message.toLocal8Bit().data() );
     }
 }
 
@@ -39,10 +55,9 @@ void Scpi::write(QString _message){
 void Scpi::reset()
 {
     QString output = "*RST";
-    qDebug() << output.toLocal8Bit().data();
 
-    if(Gpib::isNoError()){
-        Gpib::write( output.toLocal8Bit().data() );
+    if(gpib->isNoError()){
+        gpib->write( output.toLocal8Bit().data() );
     }
 }
 
@@ -52,10 +67,9 @@ void Scpi::reset()
 void Scpi::setInVoltageSourceMode()
 {
     QString output = ":SOUR:FUNC VOLT";
-    qDebug() << output.toLocal8Bit().data();
 
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
 }
 
 /**
@@ -64,10 +78,9 @@ void Scpi::setInVoltageSourceMode()
 void Scpi::setInCurrentSourceMode()
 {
     QString output = ":SOUR:FUNC CURR";
-    qDebug() << output.toLocal8Bit().data();
 
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
 }
 
 /**
@@ -76,10 +89,9 @@ void Scpi::setInCurrentSourceMode()
 void Scpi::setInFixedVoltageSourceMode()
 {
     QString output = ":SOUR:VOLT:MODE FIXED";
-    qDebug() << output.toLocal8Bit().data();
 
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
 }
 
 /**
@@ -88,10 +100,9 @@ void Scpi::setInFixedVoltageSourceMode()
 void Scpi::setInFixedCurrentSourceMode()
 {
     QString output = ":SOUR:CURR:MODE FIXED";
-    qDebug() << output.toLocal8Bit().data();
 
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
 }
 
 /**
@@ -100,10 +111,9 @@ void Scpi::setInFixedCurrentSourceMode()
 void Scpi::setInVoltageMeasureMode()
 {
     QString output = ":SENS:FUNC 'VOLT'";
-    qDebug() << output.toLocal8Bit().data();
 
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
 }
 
 /**
@@ -112,10 +122,9 @@ void Scpi::setInVoltageMeasureMode()
 void Scpi::setInCurrentMeasureMode()
 {
     QString output = ":SENS:FUNC 'CURR:DC'";
-    qDebug() << output.toLocal8Bit().data();
 
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
 }
 
 /**
@@ -125,11 +134,8 @@ void Scpi::setInCurrentMeasureMode()
  */
 void Scpi::setVoltageSourceRange(double voltageSourceRange)
 {
-    QString output = QString(":SOUR:VOLT:RANG %1").arg(voltageSourceRange);
-    qDebug() << output.toLocal8Bit().data();
-
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( SCPICommandFactory::VOLTAGE_SOURCE_RANGE( voltageSourceRange ) );
 }
 
 /**
@@ -139,11 +145,8 @@ void Scpi::setVoltageSourceRange(double voltageSourceRange)
  */
 void Scpi::setCurrentSourceRange(double currentSourceRange)
 {
-    QString output = QString(":SOUR:CURR:RANG %1").arg(currentSourceRange);
-    qDebug() << output.toLocal8Bit().data();
-
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( SCPICommandFactory::CURRENT_SOURCE_RANGE( currentSourceRange ) );
 }
 
 /**
@@ -153,10 +156,9 @@ void Scpi::setCurrentSourceRange(double currentSourceRange)
 void Scpi::setCurrentSourceRangeToMin()
 {
     QString output = QString(":SOUR:CURR:RANG MIN");
-    qDebug() << output.toLocal8Bit().data();
 
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
 }
 
 
@@ -173,10 +175,9 @@ void Scpi::concurrentMeasure( bool status )
     else
         output = ":SENS:FUNC:CONC OFF";
 
-    qDebug() << output.toLocal8Bit().data();
 
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
 }
 
 /**
@@ -187,11 +188,8 @@ void Scpi::concurrentMeasure( bool status )
 
 void Scpi::setCurrentCompliance(double currentCompliance)
 {
-    QString output = QString(":SENS:CURR:PROT %1").arg( currentCompliance );
-    qDebug() << output.toLocal8Bit().data();
-
-    if( Gpib::isNoError() )
-        Gpib::write(output.toLocal8Bit().data());
+    if( gpib->isNoError() )
+        gpib->write( SCPICommandFactory::CURRENT_COMPLIANCE( currentCompliance ) );
 }
 
 /**
@@ -202,11 +200,8 @@ void Scpi::setCurrentCompliance(double currentCompliance)
 
 void Scpi::setVoltageCompliance(double voltageCompliance)
 {
-    QString output = QString(":SENS:VOLT:PROT %1").arg( voltageCompliance );
-    qDebug() << output.toLocal8Bit().data();
-
-    if( Gpib::isNoError() )
-        Gpib::write(output.toLocal8Bit().data());
+    if( gpib->isNoError() )
+        gpib->write( SCPICommandFactory::VOLTAGE_COMPLIANCE( voltageCompliance ) );
 }
 
 /**
@@ -222,10 +217,9 @@ void Scpi::setNplc(QString nplc)
     for voltage measurements to 10 PLC, then current and resistance will also set to
     10 PLC.*/
     QString output = ":SENS:VOLT:NPLC " + nplc;
-    qDebug() << output.toLocal8Bit().data();
 
-    if( Gpib::isNoError() )
-        Gpib::write(output.toLocal8Bit().data());
+    if( gpib->isNoError() )
+        gpib->write(output.toLocal8Bit().data());
 }
 
 /**
@@ -242,10 +236,9 @@ void Scpi::setVoltageMeasureRangeInAuto(bool status)
     else
         output = ":SENS:VOLT:RANG:AUTO OFF";
 
-    qDebug() << output.toLocal8Bit().data();
 
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
 }
 
 /**
@@ -256,11 +249,8 @@ void Scpi::setVoltageMeasureRangeInAuto(bool status)
 
 void Scpi::setVoltageMeasureRange(double measureRange)
 {
-    QString output = QString(":SENS:VOLT:RANG %1").arg( measureRange );
-    qDebug() << output.toLocal8Bit().data();
-
-    if( Gpib::isNoError() )
-        Gpib::write(output.toLocal8Bit().data());
+    if( gpib->isNoError() )
+        gpib->write( SCPICommandFactory::VOLTAGE_MEASURE_RANGE( measureRange ) );
 }
 
 /**
@@ -277,9 +267,8 @@ void Scpi::setCurrentMeasureRangeInAuto(bool status)
     else
         output = ":SENS:CURR:RANG:AUTO OFF";
 
-    qDebug() << output.toLocal8Bit().data();
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
 }
 
 /**
@@ -290,11 +279,8 @@ void Scpi::setCurrentMeasureRangeInAuto(bool status)
 
 void Scpi::setCurrentMeasureRange(double measureRange)
 {
-    QString output = QString(":SENS:CURR:RANG %1").arg( measureRange );
-    qDebug() << output.toLocal8Bit().data();
-
-    if( Gpib::isNoError() )
-        Gpib::write(output.toLocal8Bit().data());
+    if( gpib->isNoError() )
+        gpib->write( SCPICommandFactory::CURRENT_MEASURE_RANGE( measureRange ) );
 }
 
 /**
@@ -310,10 +296,9 @@ void Scpi::enableFilter(bool status)
     else
         output = ":SENS:AVER:STAT OFF";
 
-    qDebug() << output.toLocal8Bit().data();
 
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
 }
 
 /**
@@ -324,11 +309,8 @@ void Scpi::enableFilter(bool status)
 
 void Scpi::setFilterCount(int filterCount)
 {
-    QString output;
-    output = QString(":SENS:AVER:COUN %1").arg( filterCount ) ;
-    qDebug() << output.toLocal8Bit().data();
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( SCPICommandFactory::FILTER_COUNT( filterCount ) );
 }
 
 /**
@@ -358,10 +340,9 @@ void Scpi::setFilterType(int filterTypeIndex)
         output = QString(":SENS:AVER:TCON NORM");
         break;
     }
-    qDebug() << output.toLocal8Bit().data();
 
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
 }
 
 /**
@@ -372,12 +353,8 @@ void Scpi::setFilterType(int filterTypeIndex)
 
 void Scpi::setVoltageSourceLevel(double sourceLevel)
 {
-    QString output;
-    output = QString( ":SOUR:VOLT:LEV %1" ).arg( sourceLevel ) ;
-    qDebug() << output.toLocal8Bit().data();
-
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( SCPICommandFactory::VOLTAGE_SOURCE_LEVEL( sourceLevel ) );
 }
 
 /**
@@ -388,12 +365,8 @@ void Scpi::setVoltageSourceLevel(double sourceLevel)
 
 void Scpi::setCurrentSourceLevel(double sourceLevel)
 {
-    QString output;
-    output = QString( ":SOUR:CURR:LEV %1" ).arg( sourceLevel ) ;
-    qDebug() << output.toLocal8Bit().data();
-
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( SCPICommandFactory::CURRENT_SOURCE_LEVEL( sourceLevel ) );
 }
 
 /**
@@ -404,12 +377,8 @@ void Scpi::setCurrentSourceLevel(double sourceLevel)
 
 void Scpi::setPulseWidth(double width)
 {
-    QString output;
-    output = QString( ":SOUR:PULS:WIDT %1" ).arg( width ) ;
-    qDebug() << output.toLocal8Bit().data();
-
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( SCPICommandFactory::PULSE_WIDTH( width ) );
 }
 
 /**
@@ -420,12 +389,8 @@ void Scpi::setPulseWidth(double width)
 
 void Scpi::setPulseDelay( double pulseDelay )
 {
-    QString output;
-    output = QString( ":SOUR:PULS:DEL %1" ).arg( pulseDelay ) ;
-    qDebug() << output.toLocal8Bit().data();
-
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( SCPICommandFactory::PULSE_DELAY( pulseDelay ) );
 }
 
 /**
@@ -442,10 +407,9 @@ void Scpi::enableOutput(bool status)
     else
         output = ":OUTP:STAT OFF";
 
-    qDebug() << output.toLocal8Bit().data();
 
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
 }
 
 
@@ -455,14 +419,14 @@ void Scpi::enableOutput(bool status)
 
 QVariant Scpi::idnQuery( const int size )
 {
+    QMutexLocker locker(gpib->ioMutex());
     QString output = QString( "*IDN?" );
-    qDebug() << output.toLocal8Bit().data();
 
-    if( Gpib::isNoError() )
+    if( gpib->isNoError() )
     {
-        Gpib::write( output.toLocal8Bit().data());
+        gpib->write( output.toLocal8Bit().data());
     }
-    return Gpib::read(size);
+    return gpib->read(size);
 }
 
 /**
@@ -471,12 +435,12 @@ QVariant Scpi::idnQuery( const int size )
 
 QVariant Scpi::readQuery( const int size )
 {
+    QMutexLocker locker(gpib->ioMutex());
     QString output = QString( ":READ?" );
-    qDebug() << output.toLocal8Bit().data();
 
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
-    return Gpib::read( size );
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
+    return gpib->read( size );
 }
 
 /**
@@ -485,11 +449,11 @@ QVariant Scpi::readQuery( const int size )
 
 QVariant Scpi::dataQuery( const int size )
 {
+    QMutexLocker locker(gpib->ioMutex());
     QString output = QString( ":TRAC:DATA?" );
-    qDebug() << output.toLocal8Bit().data();
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
-    return Gpib::read( size );
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
+    return gpib->read( size );
 }
 
 /**
@@ -498,11 +462,47 @@ QVariant Scpi::dataQuery( const int size )
 
 QVariant Scpi::fetchQuery( const int size )
 {
+    QMutexLocker locker(gpib->ioMutex());
+    QString output = QString( ":FETC?" );
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
+    return gpib->read( size );
+}
+
+/**
+  * @brief get data from instrument buffer as binary readings.
+  *
+  * The instrument must have been programmed with formatData() and formatByteOrder().
+  *
+  * @param values Is the storage for the decoded readings.
+  * @param format DATA_FORMAT_REAL32 or DATA_FORMAT_REAL64.
+  * @param swapped True if the instrument sends the least significant byte first.
+  */
+
+int Scpi::dataQueryBinary( QVector<double> &values, const int format, const bool swapped )
+{
+    QMutexLocker locker(gpib->ioMutex());
+    QString output = QString( ":TRAC:DATA?" );
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
+    return gpib->readBinaryBlock( values, format, swapped );
+}
+
+/**
+  * @brief Fetch data from instrument buffer as binary readings.
+  *
+  * @param values Is the storage for the decoded readings.
+  * @param format DATA_FORMAT_REAL32 or DATA_FORMAT_REAL64.
+  * @param swapped True if the instrument sends the least significant byte first.
+  */
+
+int Scpi::fetchQueryBinary( QVector<double> &values, const int format, const bool swapped )
+{
+    QMutexLocker locker(gpib->ioMutex());
     QString output = QString( ":FETC?" );
-    qDebug() << output.toLocal8Bit().data();
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
-    return Gpib::read( size );
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
+    return gpib->readBinaryBlock( values, format, swapped );
 }
 
 /**
@@ -512,10 +512,9 @@ QVariant Scpi::fetchQuery( const int size )
 void Scpi::initTrigger()
 {
     QString output = QString( ":INIT");
-    qDebug() << output.toLocal8Bit().data();
 
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
 }
 
 
@@ -528,10 +527,9 @@ void Scpi::initTrigger()
 void Scpi::enableMeasureFunctionsSCPI( const QString parameters )
 {
     QString output = QString( ":SENS:FUNC:ON " + parameters );
-    qDebug() << output.toLocal8Bit().data();
 
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
 }
 
 /**
@@ -561,9 +559,8 @@ void Scpi::displayTextState( const int window, bool state )
     else
         output = output + "OFF";
 
-    qDebug() << output.toLocal8Bit().data();
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
 }
 
 /**
@@ -588,9 +585,8 @@ void Scpi::displayText( const int window, const QString text )
         break;
     }
 
-    qDebug() << output.toLocal8Bit().data();
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
 
 }
 
@@ -601,17 +597,12 @@ void Scpi::displayText( const int window, const QString text )
   */
 void Scpi::setTriggerCount( int triggerCount )
 {
-    QString output;
-
     // Avoiding overcome the maximum count trigger.
     if( triggerCount > 2500 )
         triggerCount = 2500;
 
-    output = QString( ":TRIG:COUN %1" ).arg( triggerCount ) ;
-    qDebug() << output.toLocal8Bit().data();
-
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( SCPICommandFactory::TRIGGER_COUNT( triggerCount ) );
 }
 
 /**
@@ -621,13 +612,8 @@ void Scpi::setTriggerCount( int triggerCount )
   */
 void Scpi::setVoltageSweepStart(const double sweepVoltageStart)
 {
-    QString output;
-
-    output = QString( ":SOUR:VOLT:STAR %1" ).arg( sweepVoltageStart ) ;
-    qDebug() << output.toLocal8Bit().data();
-
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( SCPICommandFactory::VOLTAGE_SWEEP_START( sweepVoltageStart ) );
 }
 
 /**
@@ -637,13 +623,8 @@ void Scpi::setVoltageSweepStart(const double sweepVoltageStart)
   */
 void Scpi::setVoltageSweepStop(const double sweepVoltageStop)
 {
-    QString output;
-
-    output = QString( ":SOUR:VOLT:STOP %1" ).arg( sweepVoltageStop ) ;
-    qDebug() << output.toLocal8Bit().data();
-
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( SCPICommandFactory::VOLTAGE_SWEEP_STOP( sweepVoltageStop ) );
 }
 
 /**
@@ -653,13 +634,8 @@ void Scpi::setVoltageSweepStop(const double sweepVoltageStop)
   */
 void Scpi::setCurrentSweepStart(const double sweepCurrentStart)
 {
-    QString output;
-
-    output = QString( ":SOUR:CURR:STAR %1" ).arg( sweepCurrentStart ) ;
-    qDebug() << output.toLocal8Bit().data();
-
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( SCPICommandFactory::CURRENT_SWEEP_START( sweepCurrentStart ) );
 }
 
 /**
@@ -669,13 +645,8 @@ void Scpi::setCurrentSweepStart(const double sweepCurrentStart)
   */
 void Scpi::setCurrentSweepStop(const double sweepCurrentStop)
 {
-    QString output;
-
-    output = QString( ":SOUR:CURR:STOP %1" ).arg( sweepCurrentStop );
-    qDebug() << output.toLocal8Bit().data();
-
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( SCPICommandFactory::CURRENT_SWEEP_STOP( sweepCurrentStop ) );
 }
 
 /**
@@ -685,13 +656,8 @@ void Scpi::setCurrentSweepStop(const double sweepCurrentStop)
   */
 void Scpi::setVoltageSweepStep(const double sweepVoltageStep)
 {
-    QString output;
-
-    output = QString( ":SOUR:VOLT:STEP %1" ).arg( sweepVoltageStep );
-    qDebug() << output.toLocal8Bit().data();
-
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( SCPICommandFactory::VOLTAGE_SWEEP_STEP( sweepVoltageStep ) );
 }
 
 /**
@@ -701,13 +667,8 @@ void Scpi::setVoltageSweepStep(const double sweepVoltageStep)
   */
 void Scpi::setCurrentSweepStep(const double sweepCurrentStep)
 {
-    QString output;
-
-    output = QString( ":SOUR:CURR:STEP %1" ).arg( sweepCurrentStep );
-    qDebug() << output.toLocal8Bit().data();
-
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( SCPICommandFactory::CURRENT_SWEEP_STEP( sweepCurrentStep ) );
 }
 
 /**
@@ -716,10 +677,9 @@ void Scpi::setCurrentSweepStep(const double sweepCurrentStep)
 void Scpi::setVoltageSweepMode()
 {
     QString output = ":SOUR:VOLT:MODE SWE";
-    qDebug() << output.toLocal8Bit().data();
 
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
 }
 
 /**
@@ -728,10 +688,9 @@ void Scpi::setVoltageSweepMode()
 void Scpi::setCurrentSweepMode()
 {
     QString output = ":SOUR:CURR:MODE SWE";
-    qDebug() << output.toLocal8Bit().data();
 
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
 }
 
 /**
@@ -753,9 +712,8 @@ void Scpi::setSweepType(const int sweepType)
         output = QString(":SOUR:SWE:SPAC LIN");
         break;
     }
-    qDebug() << output.toLocal8Bit().data();
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
 }
 
 /**
@@ -765,13 +723,8 @@ void Scpi::setSweepType(const int sweepType)
   */
 void Scpi::setSweepPoints(const int sweepPoints)
 {
-    QString output;
-
-    output = QString( ":SOUR:SWE:POIN %1" ).arg( sweepPoints );
-    qDebug() << output.toLocal8Bit().data();
-
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( SCPICommandFactory::SWEEP_POINTS( sweepPoints ) );
 }
 
 /**
@@ -781,10 +734,9 @@ void Scpi::setSweepPoints(const int sweepPoints)
 void Scpi::testInstrunction(const char *instruction)
 {
     QString output = instruction;
-    qDebug() << output.toLocal8Bit().data();
 
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
 }
 
 
@@ -795,10 +747,9 @@ void Scpi::testInstrunction(const char *instruction)
 void Scpi::clearStatus()
 {
     QString output = "*CLS";
-    qDebug() << output.toLocal8Bit().data();
 
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
 }
 
 /**
@@ -809,11 +760,8 @@ void Scpi::clearStatus()
 
 void Scpi::programSrqr(const int config)
 {
-    QString output = QString("*SRE %1").arg(config);
-    qDebug() << output.toLocal8Bit().data();
-
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( SCPICommandFactory::SERVICE_REQUEST_ENABLE( config ) );
 }
 
 /**
@@ -824,11 +772,8 @@ void Scpi::programSrqr(const int config)
 
 void Scpi::programSer(const int config)
 {
-    QString output = QString("*ESE %1").arg(config);
-    qDebug() << output.toLocal8Bit().data();
-
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( SCPICommandFactory::EVENT_STATUS_ENABLE( config ) );
 }
 
 /**
@@ -839,11 +784,8 @@ void Scpi::programSer(const int config)
 
 void Scpi::programOer(const int config)
 {
-    QString output = QString(":STAT:OPER:ENAB %1").arg(config);
-    qDebug() << output.toLocal8Bit().data();
-
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( SCPICommandFactory::OPERATION_ENABLE( config ) );
 }
 
 /**
@@ -854,11 +796,8 @@ void Scpi::programOer(const int config)
 
 void Scpi::programMer(const int config)
 {
-    QString output = QString(":STAT:MEAS:ENAB %1").arg(config);
-    qDebug() << output.toLocal8Bit().data();
-
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( SCPICommandFactory::MEASUREMENT_ENABLE( config ) );
 }
 
 /**
@@ -869,11 +808,8 @@ void Scpi::programMer(const int config)
 
 void Scpi::programQer(const int config)
 {
-    QString output = QString(":STAT:QUES:ENAB %1").arg(config);
-    qDebug() << output.toLocal8Bit().data();
-
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( SCPICommandFactory::QUESTIONABLE_ENABLE( config ) );
 }
 
 /**
@@ -903,9 +839,52 @@ void Scpi::formatStatusRegister(const int format)
         break;
     }
 
-    qDebug() << output.toLocal8Bit().data();
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
+}
+
+/**
+ * @brief Select the data format used to send readings over the bus
+ *
+ * @param format An int used as an index to choose between formats: DATA_FORMAT_ASCII,
+ * DATA_FORMAT_REAL32, DATA_FORMAT_REAL64.
+ */
+
+void Scpi::formatData(const int format)
+{
+    QString output;
+    switch ( format ) {
+    case DATA_FORMAT_REAL32:
+        output = QString(":FORM:DATA REAL,32");
+        break;
+    case DATA_FORMAT_REAL64:
+        output = QString(":FORM:DATA REAL,64");
+        break;
+    default:
+        output = QString(":FORM:DATA ASC");
+        break;
+    }
+
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
+}
+
+/**
+ * @brief Select the byte order of binary readings
+ *
+ * @param swapped A bool to send the least significant byte first (SWAPped) instead of NORMal.
+ */
+
+void Scpi::formatByteOrder(const bool swapped)
+{
+    QString output;
+    if(swapped)
+        output = QString(":FORM:BORD SWAP");
+    else
+        output = QString(":FORM:BORD NORM");
+
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
 }
 
 /**
@@ -922,9 +901,8 @@ void Scpi::terminalsRoute(const bool state)
     else
         output = QString(":ROUT:TERM FRON");
 
-    qDebug() << output.toLocal8Bit().data();
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
 }
 
 /**
@@ -934,10 +912,9 @@ void Scpi::terminalsRoute(const bool state)
 void Scpi::armCounterInfinite()
 {
     QString output = QString(":ARM:COUN INF");
-    qDebug() << output.toLocal8Bit().data();
 
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
 }
 
 
@@ -949,22 +926,12 @@ void Scpi::armCounterInfinite()
 
 int Scpi::stbQuery()
 {
+    QMutexLocker locker(gpib->ioMutex());
     QString output = QString( "*STB?" );
-    qDebug() << output.toLocal8Bit().data();
-#ifndef TEST
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
-
-    QByteArray statusRegister = Gpib::read().toByteArray();
-    int i = 0;
-    while( statusRegister.at( i ) != '\n' )
-        i++;
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
 
-    statusRegister.truncate(i);
-    return statusRegister.toInt();
-#else
-    return 0;
-#endif
+    return gpib->read().toByteArray().toInt();
 }
 
 /**
@@ -975,12 +942,12 @@ int Scpi::stbQuery()
 
 QVariant Scpi::esrQuery()
 {
+    QMutexLocker locker(gpib->ioMutex());
     QString output = QString( "*ESR?" );
-    qDebug() << output.toLocal8Bit().data();
 
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
-    return Gpib::read();
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
+    return gpib->read();
 }
 
 /**
@@ -991,12 +958,12 @@ QVariant Scpi::esrQuery()
 
 QVariant Scpi::oerQuery()
 {
+    QMutexLocker locker(gpib->ioMutex());
     QString output = QString( ":STAT:OPER:EVEN?" );
-    qDebug() << output.toLocal8Bit().data();
 
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
-    return Gpib::read();
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
+    return gpib->read();
 }
 
 /**
@@ -1007,12 +974,12 @@ QVariant Scpi::oerQuery()
 
 QVariant Scpi::merQuery()
 {
+    QMutexLocker locker(gpib->ioMutex());
     QString output = QString( ":STAT:MEAS:EVEN?" );
-    qDebug() << output.toLocal8Bit().data();
 
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
-    return Gpib::read();
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
+    return gpib->read();
 }
 
 /**
@@ -1023,12 +990,12 @@ QVariant Scpi::merQuery()
 
 QVariant Scpi::qerQuery()
 {
+    QMutexLocker locker(gpib->ioMutex());
     QString output = QString( ":STAT:QUES:EVEN?" );
-    qDebug() << output.toLocal8Bit().data();
 
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
-    return Gpib::read();
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
+    return gpib->read();
 }
 
 /**
@@ -1039,14 +1006,14 @@ QVariant Scpi::qerQuery()
 
 QString Scpi::queueErrorQuery()
 {
+    QMutexLocker locker(gpib->ioMutex());
     QString output = QString( ":STAT:QUE?" );
-    qDebug() << output.toLocal8Bit().data();
 
     allResgistersQueryTest();
 
-    if( Gpib::isNoError() )
-        Gpib::write( output.toLocal8Bit().data() );
-    return Gpib::read().toString();
+    if( gpib->isNoError() )
+        gpib->write( output.toLocal8Bit().data() );
+    return gpib->read().toString();
 }
 
 /**
@@ -1055,6 +1022,7 @@ QString Scpi::queueErrorQuery()
 
 void Scpi::allResgistersQueryTest()
 {
+    QMutexLocker locker(gpib->ioMutex());
     // Status byte register
     // Event
     //QTest::qSleep(1000);
@@ -1063,9 +1031,9 @@ void Scpi::allResgistersQueryTest()
 
     // Enable
     //QTest::qSleep(1000);
-    if( Gpib::isNoError() )
-        Gpib::write("*SRE?");
-    QString statusE = Gpib::read().toString();
+    if( gpib->isNoError() )
+        gpib->write("*SRE?");
+    QString statusE = gpib->read().toString();
     statusE = statusE.append("!!");
 
     // Standard register
@@ -1075,9 +1043,9 @@ void Scpi::allResgistersQueryTest()
     standardR = standardR.append("!!");
 
     // Enable
-    if( Gpib::isNoError() )
-        Gpib::write("*ESE?");
-    QString standardE = Gpib::read().toString();
+    if( gpib->isNoError() )
+        gpib->write("*ESE?");
+    QString standardE = gpib->read().toString();
     statusE = standardE.append("!!");
 
 }
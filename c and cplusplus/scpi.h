@@ -2,6 +2,7 @@
 #define SCPI_H
 
 #include "../GPIB/gpib.h"
+#include "../GPIB/SCPICommandFactory.h"
 
 #include <QDebug>
 #include <QVariant>
@@ -12,8 +13,11 @@ class Scpi : public QObject
     Q_OBJECT
 public:
     Scpi();
+    Scpi(Gpib *device);
     ~Scpi();
 
+    Gpib *getGpib();
+
     void write(QString);
 
     void reset();
@@ -59,6 +63,9 @@ public:
     QVariant dataQuery(const int size = 42);
     QVariant idnQuery( const int size = 42);
 
+    int dataQueryBinary(QVector<double> &values, const int format = DATA_FORMAT_REAL64, const bool swapped = true);
+    int fetchQueryBinary(QVector<double> &values, const int format = DATA_FORMAT_REAL64, const bool swapped = true);
+
     void initTrigger();
 
     void enableMeasureFunctionsSCPI(const QString parameters);
@@ -94,6 +101,8 @@ public:
     void programQer(const int config);
 
     void formatStatusRegister(const int format);
+    void formatData(const int format);
+    void formatByteOrder(const bool swapped);
 
     void terminalsRoute( const bool state );
 
@@ -110,6 +119,9 @@ public:
 
     void allResgistersQueryTest();
 
+private:
+    Gpib *gpib;
+
     };
 
 #endif // SCPI_H
@@ -0,0 +1,297 @@
+#ifndef SCPIDEVICE_H
+#define SCPIDEVICE_H
+
+#include "../GPIB/parallelCommunications/gpib/gpibDriver.h"
+#include "../GPIB/SCPICommand.h"
+#include "../GPIB/scpiNumericParser.h"
+#include "../GPIB/ieee4882Block.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+
+/**
+  * @brief SCPI transport over a GPIBDriver without Qt.
+  *
+  * The Qt free core: command building (SCPICommandTemplate), transport (this class)
+  * and parsing (ScpiNumericParser, parseInt) in plain C++17, for programs that do not
+  * link Qt. GPIBPort and Gpib are the Qt adapters on top of it and keep the locking,
+  * the descriptor pool, the trace and the error signal. tests/scpiCore builds it
+  * without Qt.
+  *
+  * Header only, with no locking: use an instance per thread, or lock around it.
+  * Methods return EXIT_SUCCESS, -1 on a driver error or -2 when the device does not
+  * listen; status() has the ibsta, iberr and ibcnt of the last call.
+  */
+class SCPIDevice
+{
+public:
+    SCPIDevice(GPIBDriver *driver = 0)
+    {
+        this->driver = driver;
+        device = -1;
+    }
+
+    /**
+      * @brief Open the device with ibdev.
+      */
+    int open(GPIBDriver *driver, int boardIndex, int pad, int sad, int timo, int eot, int eos)
+    {
+        this->driver = driver;
+        device = -1;
+        lastStatus = driver->openDevice( boardIndex, pad, sad, timo, eot, eos, device );
+        return result();
+    }
+
+    /**
+      * @brief Use a descriptor opened elsewhere, e.g. taken from GPIBDescriptorPool.
+      *
+      * @param ud The descriptor, -1 to detach.
+      */
+    void attach(GPIBDriver *driver, int ud)
+    {
+        this->driver = driver;
+        device = ud;
+    }
+
+    /**
+      * @brief Take the device offline (ibonl 0).
+      */
+    void close()
+    {
+        if( device >= 0 ) lastStatus = driver->online( device, 0 );
+        device = -1;
+    }
+
+    int descriptor() const {return device;}
+    bool isOpen() const {return device >= 0;}
+    const GPIBStatus &status() const {return lastStatus;}
+
+    int write(std::string_view message)
+    {
+        if( device < 0 ) return notOpen();
+        lastStatus = driver->write( device, message.data(), (long)message.size() );
+        return result();
+    }
+
+    /**
+      * @brief Write a command built by a SCPICommandTemplate.
+      *
+      * An overflowed command is not sent: the call fails with EARG.
+      */
+    int write(const SCPICommand &command)
+    {
+        if( command.isOverflowed() ) return invalidArgument();
+        return write( command.view() );
+    }
+
+    /**
+      * @brief Read the bytes sent by the device, as they are.
+      *
+      * @param count Set to the number of bytes read, from ibcnt.
+      */
+    int read(char *buffer, int capacity, int &count)
+    {
+        count = 0;
+        if( device < 0 ) return notOpen();
+        lastStatus = driver->read( device, buffer, capacity );
+        // Never more than was asked for, even if the driver reports otherwise
+        if( lastStatus.ibcnt < 0 ) lastStatus.ibcnt = 0;
+        if( lastStatus.ibcnt > capacity ) lastStatus.ibcnt = capacity;
+        count = (int)lastStatus.ibcnt;
+        return result();
+    }
+
+    /**
+      * @brief Read a text response, without the terminator sent with END.
+      *
+      * @param response Set to the response, a view of buffer.
+      */
+    int readResponse(char *buffer, int capacity, std::string_view &response)
+    {
+        int count = 0;
+        int status = read( buffer, capacity, count );
+        if( lastStatus.isEnd() ) count = (int)stripTerminator( buffer, count );
+        response = std::string_view( buffer, count );
+        return status;
+    }
+
+    /**
+      * @brief Write a query and read its response.
+      */
+    int query(std::string_view message, char *buffer, int capacity, std::string_view &response)
+    {
+        response = std::string_view();
+        int status = write( message );
+        if( status == EXIT_SUCCESS ) status = readResponse( buffer, capacity, response );
+        return status;
+    }
+
+    /**
+      * @brief Query a register (*ESR?, :STAT:OPER:EVEN?, ...).
+      *
+      * @return EXIT_SUCCESS, a driver error, or -1 if the response is not a number.
+      */
+    int queryInt(std::string_view message, int &value)
+    {
+        char buffer[32];
+        std::string_view response;
+        int status = query( message, buffer, sizeof(buffer), response );
+        if( status == EXIT_SUCCESS && !parseInt( response, value ) ) status = -1;
+        return status;
+    }
+
+    /**
+      * @brief Query comma separated readings (:READ?, :FETC?, ...).
+      *
+      * @param buffer Storage for the response; it must hold the whole of it.
+      * @param count Set to the number of values parsed.
+      */
+    int queryValues(std::string_view message, char *buffer, int capacity, double *values, int valueCapacity, int &count)
+    {
+        count = 0;
+        std::string_view response;
+        int status = query( message, buffer, capacity, response );
+        if( status == EXIT_SUCCESS ) count = ScpiNumericParser::parse( response.data(), (int)response.size(), values, valueCapacity );
+        return status;
+    }
+
+    /**
+      * @brief Read an IEEE 488.2 binary block sent after :FORM:DATA REAL,32 or REAL,64.
+      *
+      * Both the definite length "#<n><len>" and the indefinite "#0" headers are
+      * accepted. The data is read in chunks of IEEE_BLOCK_CHUNK_SIZE bytes up to END
+      * and decoded as it arrives, so the length in the header never sizes a buffer.
+      * A response that is not a block is read to its end, so the next one starts clean.
+      *
+      * @param values Storage the readings are appended to (QVector<double>, std::vector<double>).
+      * @param format DATA_FORMAT_REAL32 or DATA_FORMAT_REAL64.
+      * @param swapped True if the instrument was programmed with :FORM:BORD SWAP.
+      * @param observer Called as observer(data, count) after every read, e.g. to trace it.
+      * @return EXIT_SUCCESS, a driver error, or -1 if the response is not a block or
+      * ends before the length in its header.
+      */
+    template<class Storage, class Observer>
+    int readBlock(Storage &values, int format, bool swapped, Observer observer)
+    {
+        const int valueSize = ieeeBlockValueSize( format );
+        if( valueSize == 0 ) return -1;
+
+        char header[12];
+        int count = 0;
+        int status = read( header, 2, count );
+        observer( header, count );
+        if( status != EXIT_SUCCESS ) return status;
+
+        long payloadLength = -1;
+        int headerLength = ( count == 2 ) ? ieeeBlockHeader( header, 2, &payloadLength ) : -1;
+        if( headerLength == 0 ){
+            int digits = header[1] - '0';
+            count = 0;
+            if( !lastStatus.isEnd() ){
+                status = read( header + 2, digits, count );
+                observer( header + 2, count );
+                if( status != EXIT_SUCCESS ) return status;
+            }
+            headerLength = ( count == digits ) ? ieeeBlockHeader( header, 2 + digits, &payloadLength ) : -1;
+        }
+        if( headerLength <= 0 ) return discard( observer );
+
+        if( payloadLength > 0 )
+            values.reserve( values.size() + (int)std::min<long>( payloadLength / valueSize, IEEE_BLOCK_RESERVE_LIMIT ) );
+
+        char chunk[IEEE_BLOCK_CHUNK_SIZE];
+        double decoded[IEEE_BLOCK_CHUNK_SIZE / 4];
+        // Bytes of a value split between two reads, kept at the start of chunk
+        int carried = 0;
+        long remaining = payloadLength;
+        // Up to END: a definite block is followed by the terminator
+        while( !lastStatus.isEnd() ){
+            status = read( chunk + carried, IEEE_BLOCK_CHUNK_SIZE - carried, count );
+            observer( chunk + carried, count );
+            if( status != EXIT_SUCCESS ) return status;
+
+            long taken = count;
+            if( remaining >= 0 ){
+                taken = std::min<long>( taken, remaining );
+                remaining -= taken;
+            }
+            int available = carried + (int)taken;
+            int decodedCount = ieeeBlockDecode( chunk, available, format, swapped, decoded, IEEE_BLOCK_CHUNK_SIZE / 4 );
+            for( int i = 0; i < decodedCount; i++ ) values.push_back( decoded[i] );
+            // What is left of an indefinite block at END is its terminator
+            carried = available - decodedCount * valueSize;
+            std::memmove( chunk, chunk + decodedCount * valueSize, carried );
+        }
+        return ( remaining > 0 ) ? -1 : EXIT_SUCCESS;
+    }
+
+    template<class Storage>
+    int readBlock(Storage &values, int format, bool swapped)
+    {
+        return readBlock( values, format, swapped, [](const char *, int){} );
+    }
+
+    /**
+      * @brief Parse an integer field, skipping the spaces around it and a leading '+'.
+      */
+    static bool parseInt(std::string_view field, int &value)
+    {
+        while( !field.empty() && field.front() == ' ' ) field.remove_prefix( 1 );
+        while( !field.empty() && field.back() == ' ' ) field.remove_suffix( 1 );
+        if( !field.empty() && field.front() == '+' ) field.remove_prefix( 1 );
+        if( field.empty() ) return false;
+
+        std::from_chars_result parsed = std::from_chars( field.data(), field.data() + field.size(), value );
+        return parsed.ec == std::errc() && parsed.ptr == field.data() + field.size();
+    }
+
+private:
+    /**
+      * @brief Read and drop the rest of a response, up to END.
+      *
+      * @return -1, or the driver error that stopped it.
+      */
+    template<class Observer>
+    int discard(Observer observer)
+    {
+        char chunk[IEEE_BLOCK_CHUNK_SIZE];
+        while( !lastStatus.isEnd() ){
+            int count = 0;
+            int status = read( chunk, IEEE_BLOCK_CHUNK_SIZE, count );
+            observer( chunk, count );
+            if( status != EXIT_SUCCESS ) return status;
+        }
+        return -1;
+    }
+
+    int notOpen()
+    {
+        lastStatus = GPIBStatus();
+        lastStatus.ibsta = ERR;
+        lastStatus.iberr = EDVR;
+        return -1;
+    }
+
+    int invalidArgument()
+    {
+        lastStatus = GPIBStatus();
+        lastStatus.ibsta = ERR;
+        lastStatus.iberr = EARG;
+        return -1;
+    }
+
+    int result() const
+    {
+        if( !lastStatus.isError() ) return EXIT_SUCCESS;
+        return ( lastStatus.iberr == ENOL ) ? -2 : -1;
+    }
+
+    GPIBDriver *driver;
+    int         device;
+    GPIBStatus  lastStatus;
+};
+
+#endif // SCPIDEVICE_H
@@ -0,0 +1,251 @@
+#include "../GPIB/scpiNumericParser.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+static const double exactPowersOfTen[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static inline bool hostIsLittleEndian()
+{
+    const unsigned short probe = 1;
+    return *reinterpret_cast<const unsigned char *>(&probe) == 1;
+}
+
+static inline bool isDigit(const char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static inline bool isSeparator(const char c)
+{
+    return c == ',' || c == ';';
+}
+
+static inline bool isSpace(const char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+/**
+  * @brief Parse a comma separated list of numbers.
+  *
+  * @param data The response, it does not need to be NUL terminated.
+  * @param length The number of bytes of data.
+  * @param values Destination array.
+  * @param capacity Maximum number of values to store.
+  * @return The number of values stored.
+  */
+int ScpiNumericParser::parse(const char *data, int length, double *values, int capacity)
+{
+    const char *p = data;
+    const char *end = data + length;
+    int count = 0;
+
+    while( count < capacity ){
+        while( p < end && isSpace(*p) ) p++;
+        if( p >= end ) break;
+        p = parseField( p, end, values[count++] );
+    }
+    return count;
+}
+
+/**
+  * @brief Parse interleaved readings into one array per element.
+  *
+  * A response of readings with elementCount elements each (e.g. VOLT,CURR,TIME) is
+  * stored de-interleaved: field i goes to columns[i % elementCount][i / elementCount].
+  *
+  * @param data The response, it does not need to be NUL terminated.
+  * @param length The number of bytes of data.
+  * @param elementCount Number of elements of every reading.
+  * @param columns One destination array per element.
+  * @param capacity Maximum number of readings every column can hold.
+  * @return The number of complete readings stored.
+  */
+int ScpiNumericParser::parseColumns(const char *data, int length, int elementCount,
+                                    double *const *columns, int capacity)
+{
+    if( elementCount <= 0 ) return 0;
+
+    const char *p = data;
+    const char *end = data + length;
+    int element = 0;
+    int reading = 0;
+
+    while( reading < capacity ){
+        while( p < end && isSpace(*p) ) p++;
+        if( p >= end ) break;
+
+        p = parseField( p, end, columns[element][reading] );
+        if( ++element == elementCount ){
+            element = 0;
+            reading++;
+        }
+    }
+    return reading;
+}
+
+/**
+  * @brief Parse one field and skip its separator.
+  *
+  * @param field First character of the field.
+  * @param end End of the response.
+  * @param value Set to the number, or NaN if the field is not a number.
+  * @return The first character after the separator of the field.
+  */
+const char *ScpiNumericParser::parseField(const char *field, const char *end, double &value)
+{
+    const char *p;
+    if( end - field >= SCPI_FIXED_NUMBER_WIDTH
+            && ( end - field == SCPI_FIXED_NUMBER_WIDTH
+                 || isSeparator( field[SCPI_FIXED_NUMBER_WIDTH] )
+                 || isSpace( field[SCPI_FIXED_NUMBER_WIDTH] ) )
+            && parseFixed( field, value ) ){
+        p = field + SCPI_FIXED_NUMBER_WIDTH;
+    } else {
+        p = parseScalar( field, end, value );
+    }
+
+    while( p < end && !isSeparator(*p) ) p++;
+    if( p < end ) p++;
+    return p;
+}
+
+/**
+  * @brief Fast path for "+d.ddddddE+dd".
+  *
+  * The mantissa digit and the 6 decimals are loaded as one 64-bit word, checked
+  * and converted to an integer with three multiplications (SWAR).
+  */
+bool ScpiNumericParser::parseFixed(const char *field, double &value)
+{
+    const char sign = field[0];
+    if( ( sign != '+' && sign != '-' ) || field[2] != '.'
+            || ( field[9] != 'E' && field[9] != 'e' )
+            || ( field[10] != '+' && field[10] != '-' )
+            || !isDigit( field[11] ) || !isDigit( field[12] ) )
+        return false;
+
+    unsigned long long mantissa = 0;
+    if( hostIsLittleEndian() ){
+        // "d.dddddd" -> "0ddddddd": drop the point, keeping the digits in memory order
+        unsigned long long word;
+        memcpy( &word, field + 1, 8 );
+        word = ( word & 0xFFFFFFFFFFFF0000ULL ) | ( ( word & 0xFF ) << 8 ) | 0x30;
+
+        if( ( ( word & 0xF0F0F0F0F0F0F0F0ULL )
+              | ( ( ( word + 0x0606060606060606ULL ) & 0xF0F0F0F0F0F0F0F0ULL ) >> 4 ) )
+                != 0x3333333333333333ULL )
+            return false;
+
+        word -= 0x3030303030303030ULL;
+        word = ( word * 10 ) + ( word >> 8 );
+        word = ( ( ( word & 0x000000FF000000FFULL ) * ( 100 + ( 1000000ULL << 32 ) ) )
+                 + ( ( ( word >> 16 ) & 0x000000FF000000FFULL ) * ( 1 + ( 10000ULL << 32 ) ) ) ) >> 32;
+        mantissa = word & 0xFFFFFFFFULL;
+    } else {
+        if( !isDigit( field[1] ) ) return false;
+        mantissa = field[1] - '0';
+        for( int i = 3; i < 9; i++ ){
+            if( !isDigit( field[i] ) ) return false;
+            mantissa = mantissa * 10 + ( field[i] - '0' );
+        }
+    }
+
+    int exponent = ( field[11] - '0' ) * 10 + ( field[12] - '0' );
+    if( field[10] == '-' ) exponent = -exponent;
+
+    value = scale( mantissa, exponent - 6 );
+    if( sign == '-' ) value = -value;
+    return true;
+}
+
+/**
+  * @brief Scalar fallback for any other decimal number.
+  *
+  * @return The first character after the number.
+  */
+const char *ScpiNumericParser::parseScalar(const char *field, const char *end, double &value)
+{
+    const char *p = field;
+    bool negative = false;
+    if( p < end && ( *p == '+' || *p == '-' ) ){
+        negative = ( *p == '-' );
+        p++;
+    }
+
+    unsigned long long mantissa = 0;
+    int exponent = 0;
+    int digits = 0;
+    int significant = 0;
+
+    for( ; p < end && isDigit(*p); p++, digits++ ){
+        if( significant < 19 ){
+            mantissa = mantissa * 10 + ( *p - '0' );
+            if( mantissa != 0 ) significant++;
+        } else {
+            exponent++;
+        }
+    }
+    if( p < end && *p == '.' ){
+        for( p++; p < end && isDigit(*p); p++, digits++ ){
+            if( significant < 19 ){
+                mantissa = mantissa * 10 + ( *p - '0' );
+                if( mantissa != 0 ) significant++;
+                exponent--;
+            }
+        }
+    }
+    if( digits == 0 ){
+        value = std::numeric_limits<double>::quiet_NaN();
+        return p;
+    }
+
+    if( p < end && ( *p == 'E' || *p == 'e' ) ){
+        const char *e = p + 1;
+        bool negativeExponent = false;
+        if( e < end && ( *e == '+' || *e == '-' ) ){
+            negativeExponent = ( *e == '-' );
+            e++;
+        }
+        if( e < end && isDigit(*e) ){
+            int power = 0;
+            for( ; e < end && isDigit(*e); e++ )
+                if( power < 10000 ) power = power * 10 + ( *e - '0' );
+            exponent += negativeExponent ? -power : power;
+            p = e;
+        }
+    }
+
+    value = scale( mantissa, exponent );
+    if( negative ) value = -value;
+    return p;
+}
+
+/**
+  * @brief mantissa * 10^exponent, correctly rounded.
+  *
+  * When the mantissa fits in 53 bits and the exponent is within +-22 a single
+  * multiplication or division by an exact power of ten is enough. Other values
+  * (e.g. the 9.91E+37 overflow marker) go through strtod, written without a
+  * decimal point so the conversion does not depend on the locale.
+  */
+double ScpiNumericParser::scale(unsigned long long mantissa, int exponent)
+{
+    if( mantissa == 0 ) return 0.0;
+
+    if( mantissa < ( 1ULL << 53 ) ){
+        double m = (double)mantissa;
+        if( exponent >= 0 && exponent <= 22 ) return m * exactPowersOfTen[exponent];
+        if( exponent < 0 && exponent >= -22 ) return m / exactPowersOfTen[-exponent];
+    }
+
+    char text[48];
+    snprintf( text, sizeof(text), "%lluE%d", mantissa, exponent );
+    return strtod( text, 0 );
+}
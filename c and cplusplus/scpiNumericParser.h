@@ -0,0 +1,32 @@
+#ifndef SCPINUMERICPARSER_H
+#define SCPINUMERICPARSER_H
+
+/**
+  * Width of a reading in the Keithley ASCII format: "+d.ddddddE+dd"
+  */
+#define SCPI_FIXED_NUMBER_WIDTH 13
+
+/**
+  * @brief Parsers for comma separated SCPI numeric responses.
+  *
+  * Readings in the fixed width Keithley format ("+9.979305E-01") are converted
+  * with a SWAR fast path that handles the 7 mantissa digits as one 64-bit word.
+  * Any other number goes through a scalar fallback. Both are locale independent
+  * and do not allocate. Fields that are not numbers are stored as NaN.
+  */
+class ScpiNumericParser
+{
+public:
+    static int parse(const char *data, int length, double *values, int capacity);
+    static int parseColumns(const char *data, int length, int elementCount,
+                            double *const *columns, int capacity);
+
+    static const char *parseField(const char *field, const char *end, double &value);
+
+private:
+    static bool parseFixed(const char *field, double &value);
+    static const char *parseScalar(const char *field, const char *end, double &value);
+    static double scale(unsigned long long mantissa, int exponent);
+};
+
+#endif // SCPINUMERICPARSER_H
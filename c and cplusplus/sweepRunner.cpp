@@ -0,0 +1,125 @@
+#include "../GPIB/sweepRunner.h"
+
+#include "./Instruments/keithley/sourceMeters/K24xxConfigurationParameters.h"
+
+/**
+  * @brief Constructor
+  *
+  * @param port The GPIBPort of the SourceMeter. It must be already open.
+  */
+SweepRunner::SweepRunner(GPIBPort *port)
+{
+    this->port = port;
+}
+
+SweepRunner::~SweepRunner()
+{
+}
+
+/**
+  * @brief Number of points of a sweep.
+  */
+int SweepRunner::sweepPoints(const SweepConfig &config)
+{
+    if( config.sweepType == LOG || config.step == 0 ) return config.points;
+    return qRound( ( config.stop - config.start ) / config.step ) + 1;
+}
+
+/**
+  * @brief Run a sweep inside the instrument and fetch all its readings.
+  *
+  * @param config The sweep to run.
+  * @param result Is the storage for the readings, one column per element. It is
+  * reserved with the size of the buffer of readings of the instrument.
+  * @return EXIT_SUCCESS or the GPIB error status.
+  */
+int SweepRunner::runSweep(const SweepConfig &config, ReadingBuffer &result)
+{
+    int points = sweepPoints(config);
+    result.setElements( config.elements );
+    if( points < 1 || result.elementCount() == 0 ) return -1;
+    result.reserve( points );
+
+    SCPICommandBatch batch;
+    programSweep( config, batch );
+    // Settings the sweep does not program are asked now, while the instrument is idle
+    port->expectedMeasurementTime();
+    int status = batch.flush( port );
+    if( status != EXIT_SUCCESS ) return status;
+
+    // The OPC bit raises SRQ through the Event Summary Bit when the sweep ends
+    {
+        GPIBTimeoutGuard timeout( port, port->measurementTimeout() );
+        status = port->waitForServiceRequest( STB_ESB );
+    }
+    if( status != EXIT_SUCCESS ) return status;
+    port->esrQuery();
+
+    status = fetchReadings( config, result );
+
+    if( config.outputOffWhenDone ) port->write( commandFactory.enableOutput(false) );
+    return status;
+}
+
+/**
+  * @brief Add the commands that program and trigger the sweep to a batch.
+  */
+void SweepRunner::programSweep(const SweepConfig &config, SCPICommandBatch &batch)
+{
+    int points = sweepPoints(config);
+
+    batch << commandFactory.clearStatus();
+    if( config.voltageSource ){
+        batch << commandFactory.setInVoltageSourceMode()
+              << commandFactory.setInCurrentMeasureMode()
+              << commandFactory.setCurrentCompliance( config.compliance )
+              << commandFactory.setVoltageSweepStart( config.start )
+              << commandFactory.setVoltageSweepStop( config.stop );
+        if( config.sweepType != LOG ) batch << commandFactory.setVoltageSweepStep( config.step );
+        batch << commandFactory.setVoltageSweepMode();
+    } else {
+        batch << commandFactory.setInCurrentSourceMode()
+              << commandFactory.setInVoltageMeasureMode()
+              << commandFactory.setVoltageCompliance( config.compliance )
+              << commandFactory.setCurrentSweepStart( config.start )
+              << commandFactory.setCurrentSweepStop( config.stop );
+        if( config.sweepType != LOG ) batch << commandFactory.setCurrentSweepStep( config.step );
+        batch << commandFactory.setCurrentSweepMode();
+    }
+    batch << commandFactory.setSweepType( config.sweepType );
+    if( config.sweepType == LOG ) batch << commandFactory.setSweepPoints( points );
+
+    batch << commandFactory.setNplc( config.nplc )
+          << commandFactory.formatElements( config.elements )
+          << commandFactory.formatData( config.dataFormat )
+          << commandFactory.formatByteOrder( true )
+          << commandFactory.setTriggerCount( points )
+          << commandFactory.clearBufferOfReadings()
+          << commandFactory.setBufferOfReadingsSize( points )
+          << commandFactory.enableBufferOfReadings()
+          << commandFactory.programSer( ESR_OPC )
+          << commandFactory.enableOutput( true )
+          << commandFactory.initTrigger()
+          << commandFactory.operationComplete();
+}
+
+/**
+  * @brief Read the buffer of readings with one :TRAC:DATA? into the columns of result.
+  */
+int SweepRunner::fetchReadings(const SweepConfig &config, ReadingBuffer &result)
+{
+    GPIBBusLock bus( BOARD_INDEX, port->getAddress(), BUS_PRIORITY_BULK );
+    int status = port->write( commandFactory.dataQuery() );
+    if( status != EXIT_SUCCESS ) return status;
+
+    if( config.dataFormat == DATA_FORMAT_ASCII ){
+        QByteArray response;
+        status = port->readAll( response );
+        result.appendAscii( response.constData(), response.size() );
+    } else {
+        QVector<double> values;
+        status = port->readBinaryBlock( values, config.dataFormat, true );
+        result.appendInterleaved( values.constData(), values.size() );
+    }
+    return status;
+}
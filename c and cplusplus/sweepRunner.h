@@ -0,0 +1,71 @@
+#ifndef SWEEPRUNNER_H
+#define SWEEPRUNNER_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "./gpib/SCPICommandFactory.h"
+#include "./gpib/SCPICommandBatch.h"
+#include "./gpib/readingBuffer.h"
+#include "./gpib/parallelCommunications/gpib/gpibPort.h"
+
+/**
+  * @brief Parameters of a sweep run inside a 24xx SourceMeter.
+  */
+struct SweepConfig
+{
+    bool    voltageSource;  // Source voltage and measure current, or the opposite
+    double  start;
+    double  stop;
+    double  step;
+    int     points;         // Number of points, used for LOG sweeps
+    int     sweepType;      // LINEAR or LOG
+    double  compliance;
+    QString nplc;
+    QString elements;       // Elements of every reading, e.g. "VOLT,CURR"
+    int     dataFormat;     // DATA_FORMAT_REAL32, DATA_FORMAT_REAL64 or DATA_FORMAT_ASCII
+    bool    outputOffWhenDone;
+
+    SweepConfig()
+    {
+        voltageSource = true;
+        start = 0;
+        stop = 0;
+        step = 0;
+        points = 0;
+        sweepType = 0;
+        compliance = 0;
+        nplc = "1";
+        elements = "VOLT,CURR";
+        dataFormat = DATA_FORMAT_REAL64;
+        outputOffWhenDone = true;
+    }
+};
+
+/**
+  * @brief Runs a complete sweep inside the instrument and fetches it in one transfer.
+  *
+  * The sweep and the buffer of readings are programmed in one batch, the sweep is
+  * triggered, the completion is signalled by the instrument through *OPC and SRQ,
+  * and the whole buffer is read with a single :TRAC:DATA?.
+  */
+class SweepRunner
+{
+public:
+    SweepRunner(GPIBPort *port);
+    ~SweepRunner();
+
+    int runSweep(const SweepConfig &config, ReadingBuffer &result);
+
+    static int sweepPoints(const SweepConfig &config);
+
+private:
+    void programSweep(const SweepConfig &config, SCPICommandBatch &batch);
+    int  fetchReadings(const SweepConfig &config, ReadingBuffer &result);
+
+    GPIBPort *port;
+    SCPICommandFactory commandFactory;
+};
+
+#endif // SWEEPRUNNER_H
@@ -0,0 +1,22 @@
+# Builds the Qt free SCPI core (SCPICommand.h, scpiDevice.h, scpiNumericParser) on
+# its own, without Qt, and checks it against an in process loopback driver.
+#
+# Built from the application tree, where this module is gpib/ (see gpib.pri).
+
+TEMPLATE = app
+TARGET = tst_scpiCore
+CONFIG -= qt app_bundle
+CONFIG += console c++17
+
+DEFINES += TEST
+INCLUDEPATH += $$PWD/../../..
+
+HEADERS += \
+    $$PWD/../../SCPICommand.h \
+    $$PWD/../../ieee4882Block.h \
+    $$PWD/../../scpiDevice.h \
+    $$PWD/../../scpiNumericParser.h
+
+SOURCES += \
+    $$PWD/../../scpiNumericParser.cpp \
+    $$PWD/tst_scpiCore.cpp
@@ -0,0 +1,225 @@
+#include "./gpib/scpiDevice.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    if( !(condition) ){ \
+        std::printf( "FAIL %s:%d: %s\n", __FILE__, __LINE__, #condition ); \
+        failures++; \
+    }
+
+/**
+  * @brief Driver that answers the queries of the tests. Descriptor 1 is the
+  * instrument; 2 is a device that does not listen.
+  */
+class LoopbackDriver: public GPIBDriver
+{
+public:
+    std::string written;
+    // Response to :TRAC:DATA?, read at most maxRead bytes at a time
+    std::string block;
+    long maxRead = 0;
+    size_t offset = 0;
+
+    GPIBStatus ask( int, int, int *value ) {*value = 0; return done( 0 );}
+    GPIBStatus config( int, int, int ) {return done( 0 );}
+    GPIBStatus openDevice( int, int pad, int, int, int, int, int &ud ) {ud = pad == 24 ? 1 : 2; return done( 0 );}
+    GPIBStatus online( int, int ) {return done( 0 );}
+    GPIBStatus clear( int ) {return done( 0 );}
+    GPIBStatus goToLocal( int ) {return done( 0 );}
+    GPIBStatus findListener( int, int, int, short *listen ) {*listen = 1; return done( 0 );}
+    GPIBStatus setPrimaryAddress( int, int ) {return done( 0 );}
+    GPIBStatus setSecondaryAddress( int, int ) {return done( 0 );}
+    GPIBStatus interfaceClear( int ) {return done( 0 );}
+    GPIBStatus remoteEnable( int, int ) {return done( 0 );}
+    GPIBStatus setTimeout( int, int ) {return done( 0 );}
+    GPIBStatus wait( int, int ) {return done( 0 );}
+    GPIBStatus serialPoll( int, char *spr ) {*spr = 0; return done( 0 );}
+    GPIBStatus writeAsync( int, const char *, long ) {return done( 0 );}
+    GPIBStatus readAsync( int, char *, long ) {return done( 0 );}
+    GPIBStatus notify( int, int, GpibNotifyReceiver * ) {return done( 0 );}
+    GPIBStatus stop( int ) {return done( 0 );}
+
+    GPIBStatus write( int ud, const char *data, long count )
+    {
+        if( ud != 1 ){
+            GPIBStatus status;
+            status.ibsta = ERR;
+            status.iberr = ENOL;
+            return status;
+        }
+        written.assign( data, count );
+        offset = 0;
+        return done( count );
+    }
+
+    GPIBStatus read( int, char *buffer, long count )
+    {
+        std::string response = written;
+        if( written == "*ESR?" ) response = "+32\n";
+        else if( written == ":READ?" ) response = "+9.979305E-01,-1.000000E-03,+1.000000E+00,+2.500000E-03\n";
+        else if( written == ":TRAC:DATA?" ) response = block;
+        if( maxRead > 0 && count > maxRead ) count = maxRead;
+
+        long length = (long)( response.size() - offset );
+        GPIBStatus status = done( length < count ? length : count );
+        if( length <= count ) status.ibsta |= END;
+        memcpy( buffer, response.data() + offset, status.ibcnt );
+        offset += status.ibcnt;
+        return status;
+    }
+
+private:
+    static GPIBStatus done( long count )
+    {
+        GPIBStatus status;
+        status.ibsta = CMPL;
+        status.ibcnt = count;
+        return status;
+    }
+};
+
+static void commands()
+{
+    constexpr SCPICommandTemplate<double> LEVEL( ":SOUR:VOLT:LEV " );
+    constexpr SCPICommandTemplate<int, bool> PAIR( ":TEST " );
+    constexpr SCPICommandTemplate<> RESET( "*RST" );
+
+    CHECK( LEVEL( 1.5 ).view() == ":SOUR:VOLT:LEV 1.5" );
+    CHECK( LEVEL( 0.0001 ).view() == ":SOUR:VOLT:LEV 0.0001" );
+    CHECK( PAIR( 3, true ).view() == ":TEST 3,ON" );
+    CHECK( RESET().view() == "*RST" );
+    CHECK( !LEVEL( 1.5 ).isOverflowed() );
+
+    constexpr SCPICommandTemplate<double, double, double, double, double> LIST( ":SOUR:LIST:VOLT " );
+    CHECK( LIST( 1.23456e-05, 2.23456e-05, 3.23456e-05, 4.23456e-05, 5.23456e-05 ).isOverflowed() );
+}
+
+static void transport()
+{
+    LoopbackDriver driver;
+    SCPIDevice device;
+    CHECK( device.write( "*RST" ) == -1 );
+    CHECK( device.status().iberr == EDVR );
+
+    CHECK( device.open( &driver, 0, 24, 0, 0, 1, 0 ) == EXIT_SUCCESS );
+    CHECK( device.isOpen() );
+
+    constexpr SCPICommandTemplate<int> COUNT( ":TRIG:COUN " );
+    CHECK( device.write( COUNT( 10 ) ) == EXIT_SUCCESS );
+    CHECK( driver.written == ":TRIG:COUN 10" );
+
+    // Only part of it would be sent
+    constexpr SCPICommandTemplate<double, double, double, double, double> LIST( ":SOUR:LIST:VOLT " );
+    CHECK( device.write( LIST( 1.23456e-05, 2.23456e-05, 3.23456e-05, 4.23456e-05, 5.23456e-05 ) ) == -1 );
+    CHECK( device.status().iberr == EARG );
+    CHECK( driver.written == ":TRIG:COUN 10" );
+
+    int esr = 0;
+    CHECK( device.queryInt( "*ESR?", esr ) == EXIT_SUCCESS );
+    CHECK( esr == 32 );
+
+    char buffer[128];
+    std::string_view response;
+    CHECK( device.query( "*IDN?", buffer, sizeof(buffer), response ) == EXIT_SUCCESS );
+    CHECK( response == "*IDN?" );
+
+    double values[4];
+    int count = 0;
+    CHECK( device.queryValues( ":READ?", buffer, sizeof(buffer), values, 4, count ) == EXIT_SUCCESS );
+    CHECK( count == 4 );
+    CHECK( std::fabs( values[0] - 0.9979305 ) < 1e-12 );
+    CHECK( values[3] == 0.0025 );
+
+    SCPIDevice absent;
+    CHECK( absent.open( &driver, 0, 5, 0, 0, 1, 0 ) == EXIT_SUCCESS );
+    CHECK( absent.write( "*RST" ) == -2 );
+
+    device.close();
+    CHECK( !device.isOpen() );
+}
+
+/**
+  * @brief Block of values as the instrument sends it, in host byte order.
+  */
+template<class Value>
+static std::string valueBlock(const std::string &header, int count)
+{
+    std::string block = header;
+    for( int i = 0; i < count; i++ ){
+        Value value = (Value)( i * 0.5 );
+        block.append( reinterpret_cast<const char *>( &value ), sizeof(Value) );
+    }
+    return block + "\n";
+}
+
+static void blocks()
+{
+    const unsigned short probe = 1;
+    const bool hostOrder = *reinterpret_cast<const unsigned char *>( &probe ) == 1;
+
+    LoopbackDriver driver;
+    SCPIDevice device;
+    CHECK( device.open( &driver, 0, 24, 0, 0, 1, 0 ) == EXIT_SUCCESS );
+
+    // Values split between reads
+    driver.maxRead = 1001;
+    driver.block = valueBlock<float>( "#512000", 3000 );
+    std::vector<double> values;
+    CHECK( device.write( ":TRAC:DATA?" ) == EXIT_SUCCESS );
+    CHECK( device.readBlock( values, DATA_FORMAT_REAL32, hostOrder ) == EXIT_SUCCESS );
+    CHECK( values.size() == 3000 );
+    CHECK( values[2999] == 1499.5 );
+
+    values.clear();
+    driver.block = valueBlock<double>( "#0", 700 );
+    CHECK( device.write( ":TRAC:DATA?" ) == EXIT_SUCCESS );
+    CHECK( device.readBlock( values, DATA_FORMAT_REAL64, hostOrder ) == EXIT_SUCCESS );
+    CHECK( values.size() == 700 );
+    CHECK( values[699] == 349.5 );
+    driver.maxRead = 0;
+
+    // A length far beyond the data is not trusted
+    values.clear();
+    driver.block = valueBlock<double>( "#9999999999", 2 );
+    CHECK( device.write( ":TRAC:DATA?" ) == EXIT_SUCCESS );
+    CHECK( device.readBlock( values, DATA_FORMAT_REAL64, hostOrder ) == -1 );
+    CHECK( values.size() == 2 );
+
+    // Not a block, or fewer length digits than announced: the rest is dropped
+    driver.block = "+1.000000E+00,+2.000000E+00\n";
+    CHECK( device.write( ":TRAC:DATA?" ) == EXIT_SUCCESS );
+    CHECK( device.readBlock( values, DATA_FORMAT_REAL64, hostOrder ) == -1 );
+    CHECK( driver.offset == driver.block.size() );
+
+    driver.block = "#512";
+    CHECK( device.write( ":TRAC:DATA?" ) == EXIT_SUCCESS );
+    CHECK( device.readBlock( values, DATA_FORMAT_REAL64, hostOrder ) == -1 );
+    CHECK( driver.offset == driver.block.size() );
+}
+
+static void parsing()
+{
+    int value = 0;
+    CHECK( SCPIDevice::parseInt( " +12 ", value ) && value == 12 );
+    CHECK( SCPIDevice::parseInt( "-3", value ) && value == -3 );
+    CHECK( !SCPIDevice::parseInt( "", value ) );
+    CHECK( !SCPIDevice::parseInt( "1.5", value ) );
+}
+
+int main()
+{
+    commands();
+    transport();
+    blocks();
+    parsing();
+
+    if( failures == 0 ) std::printf( "PASS\n" );
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,17 @@
+# Runs the GPIB layer against SimulatedK24xx, with no board and no instrument.
+#
+# Built from the application tree, where this module is gpib/ (see gpib.pri).
+
+TEMPLATE = app
+TARGET = tst_simulatedK24xx
+QT -= gui
+CONFIG += console
+CONFIG -= app_bundle
+
+DEFINES += TEST
+INCLUDEPATH += $$PWD/../../..
+
+include(../../gpib.pri)
+
+SOURCES += \
+    $$PWD/tst_simulatedK24xx.cpp
@@ -0,0 +1,230 @@
+#include "./gpib/parallelCommunications/gpib/gpibPort.h"
+#include "./gpib/parallelCommunications/gpib/gpibQueryPipeline.h"
+#include "./gpib/parallelCommunications/gpib/simulatedK24xx.h"
+#include "./gpib/sweepRunner.h"
+
+#include <cmath>
+#include <cstdio>
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    if( !(condition) ){ \
+        std::printf( "FAIL %s:%d: %s\n", __FILE__, __LINE__, #condition ); \
+        failures++; \
+    }
+
+/**
+  * @brief Every query of a pipeline gets its own field of the response.
+  */
+static void pipelinedQueries(GPIBPort &port)
+{
+    port.write( QString( "*ESE 32;*SRE 16" ) );
+
+    GPIBQueryPipeline pipeline( &port );
+    std::future<QByteArray> serviceRequest = pipeline.enqueue( "*SRE?" );
+    std::future<QByteArray> eventStatus = pipeline.enqueue( "*ESE?" );
+    CHECK( pipeline.count() == 2 );
+    CHECK( pipeline.flush() == EXIT_SUCCESS );
+    CHECK( pipeline.isEmpty() );
+    CHECK( serviceRequest.get().toInt() == 16 );
+    CHECK( eventStatus.get().toInt() == 32 );
+}
+
+/**
+  * @brief The event registers are read, and reset, with one write and one read.
+  */
+static void pipelinedRegisterQueries(GPIBPort &port)
+{
+    int esr = -1, oer = -1, mer = -1, qer = -1;
+    CHECK( port.eventRegistersQuery( esr, oer, mer, qer ) == EXIT_SUCCESS );
+
+    // A command error sets bit 5 of the Standard Event register
+    port.write( QString( ":BOGUS 1" ) );
+    port.setNoError( true );
+    CHECK( port.eventRegistersQuery( esr, oer, mer, qer ) == EXIT_SUCCESS );
+    CHECK( ( esr & 32 ) == 32 );
+
+    // Read again, it has been reset
+    CHECK( port.eventRegistersQuery( esr, oer, mer, qer ) == EXIT_SUCCESS );
+    CHECK( esr == 0 );
+}
+
+/**
+  * @brief Queries that are never flushed get an empty response.
+  */
+static void unflushedQueries(GPIBPort &port)
+{
+    std::future<QByteArray> response;
+    {
+        GPIBQueryPipeline pipeline( &port );
+        response = pipeline.enqueue( "*ESR?" );
+    }
+    CHECK( response.get().isEmpty() );
+}
+
+/**
+  * @brief Sweep 0 to 1 V in 0.25 V steps on the 1 kOhm load of the simulator.
+  */
+static SweepConfig sweepConfig(int dataFormat)
+{
+    SweepConfig config;
+    config.start = 0;
+    config.stop = 1;
+    config.step = 0.25;
+    config.compliance = 0.1;
+    config.nplc = "0.1";
+    config.dataFormat = dataFormat;
+    return config;
+}
+
+/**
+  * @brief Every reading of a 0 to 1 V sweep on the load is there, in order.
+  */
+static bool isSweepOnLoad(const ReadingBuffer &readings)
+{
+    if( readings.size() != 5 ) return false;
+    for( int i = 0; i < readings.size(); i++ ){
+        double voltage = 0.25 * i;
+        if( std::fabs( readings.value( i, 0 ) - voltage ) > 1e-6 ) return false;
+        if( std::fabs( readings.value( i, 1 ) - voltage / SIMULATED_K24XX_LOAD ) > 1e-9 ) return false;
+    }
+    return true;
+}
+
+/**
+  * @brief A sweep run again with the state cache on still triggers and reads the
+  * buffer, even if most of its settings are not sent again.
+  */
+static void repeatedSweepsWithCache(GPIBPort &port)
+{
+    port.setStateCacheEnabled( true );
+    SweepRunner runner( &port );
+    for( int i = 0; i < 3; i++ ){
+        ReadingBuffer readings;
+        CHECK( runner.runSweep( sweepConfig( DATA_FORMAT_REAL64 ), readings ) == EXIT_SUCCESS );
+        CHECK( isSweepOnLoad( readings ) );
+    }
+    port.setStateCacheEnabled( false );
+}
+
+/**
+  * @brief *RCL restores a saved setup and clears the state cache, so a setting
+  * cached before it is sent again.
+  */
+static void recallSetup(GPIBPort &port)
+{
+    port.setStateCacheEnabled( true );
+    CHECK( port.write( QString( ":SENS:CURR:NPLC 1" ) ) == EXIT_SUCCESS );
+    CHECK( port.write( QString( "*SAV 1" ) ) == EXIT_SUCCESS );
+
+    for( int i = 0; i < 2; i++ ){
+        CHECK( port.write( QString( ":SENS:CURR:NPLC 10" ) ) == EXIT_SUCCESS );
+        CHECK( port.write( QString( "*RCL 1" ) ) == EXIT_SUCCESS );
+        CHECK( !port.getStateCache()->contains( "SENS:CURR:NPLC" ) );
+
+        QByteArray nplc;
+        CHECK( port.write( QString( ":SENS:CURR:NPLC?" ) ) == EXIT_SUCCESS );
+        CHECK( port.readAll( nplc ) == EXIT_SUCCESS );
+        CHECK( nplc.toDouble() == 1 );
+    }
+
+    // *SAV is sent every time
+    CHECK( port.write( QString( ":SENS:CURR:NPLC 2" ) ) == EXIT_SUCCESS );
+    CHECK( port.write( QString( "*SAV 1" ) ) == EXIT_SUCCESS );
+    CHECK( port.write( QString( ":SENS:CURR:NPLC 3" ) ) == EXIT_SUCCESS );
+    CHECK( port.write( QString( "*SAV 1" ) ) == EXIT_SUCCESS );
+    CHECK( port.write( QString( "*RCL 1" ) ) == EXIT_SUCCESS );
+    QByteArray nplc;
+    CHECK( port.write( QString( ":SENS:CURR:NPLC?" ) ) == EXIT_SUCCESS );
+    CHECK( port.readAll( nplc ) == EXIT_SUCCESS );
+    CHECK( nplc.toDouble() == 3 );
+
+    // Setups 0 to 4 only
+    int esr = -1, oer = -1, mer = -1, qer = -1;
+    port.write( QString( "*RCL 5" ) );
+    port.setNoError( true );
+    CHECK( port.eventRegistersQuery( esr, oer, mer, qer ) == EXIT_SUCCESS );
+    CHECK( ( esr & 32 ) == 32 );
+
+    SweepRunner runner( &port );
+    ReadingBuffer readings;
+    CHECK( runner.runSweep( sweepConfig( DATA_FORMAT_REAL64 ), readings ) == EXIT_SUCCESS );
+    CHECK( isSweepOnLoad( readings ) );
+    port.setStateCacheEnabled( false );
+}
+
+/**
+  * @brief A setting sent by a raw or an asynchronous write is not taken as redundant
+  * when the cached value is sent again.
+  */
+static void rawWritesAndCache(GPIBPort &port)
+{
+    port.setStateCacheEnabled( true );
+    QByteArray level;
+    CHECK( port.write( QString( ":SOUR:VOLT:LEV 1" ) ) == EXIT_SUCCESS );
+    CHECK( port.write( ":SOUR:VOLT:LEV 2", 16 ) == EXIT_SUCCESS );
+    CHECK( port.write( QString( ":SOUR:VOLT:LEV 1" ) ) == EXIT_SUCCESS );
+    CHECK( port.write( QString( ":SOUR:VOLT:LEV?" ) ) == EXIT_SUCCESS );
+    CHECK( port.readAll( level ) == EXIT_SUCCESS );
+    CHECK( level.toDouble() == 1 );
+
+    long count = 0;
+    CHECK( port.writeAsync( ":SOUR:VOLT:LEV 3", 16 ) == EXIT_SUCCESS );
+    CHECK( port.waitAsync( count ) == EXIT_SUCCESS );
+    CHECK( port.write( QString( ":SOUR:VOLT:LEV 1" ) ) == EXIT_SUCCESS );
+    CHECK( port.write( QString( ":SOUR:VOLT:LEV?" ) ) == EXIT_SUCCESS );
+    CHECK( port.readAll( level ) == EXIT_SUCCESS );
+    CHECK( level.toDouble() == 1 );
+    port.setStateCacheEnabled( false );
+}
+
+/**
+  * @brief The expected measurement time follows a trigger count sent by a raw write.
+  */
+static void measurementTime(GPIBPort &port)
+{
+    port.setStateCacheEnabled( true );
+    CHECK( port.write( ":TRIG:COUN 1", 12 ) == EXIT_SUCCESS );
+    long single = port.expectedMeasurementTime();
+    CHECK( single > 0 );
+    CHECK( port.write( ":TRIG:COUN 10", 13 ) == EXIT_SUCCESS );
+    CHECK( port.expectedMeasurementTime() >= 10 * single );
+    port.setStateCacheEnabled( false );
+}
+
+/**
+  * @brief :TRAC:DATA? read as text and as REAL32 and REAL64 blocks gives the same readings.
+  */
+static void traceData(GPIBPort &port)
+{
+    const int formats[] = { DATA_FORMAT_ASCII, DATA_FORMAT_REAL32, DATA_FORMAT_REAL64 };
+    SweepRunner runner( &port );
+    for( int format : formats ){
+        ReadingBuffer readings;
+        CHECK( runner.runSweep( sweepConfig( format ), readings ) == EXIT_SUCCESS );
+        CHECK( isSweepOnLoad( readings ) );
+    }
+}
+
+int main()
+{
+    SimulatedK24xx instrument;
+    instrument.setTimeScale( 0.01 );
+
+    GPIBPort port( SIMULATED_K24XX_ADDRESS );
+    port.setDriver( &instrument );
+    CHECK( port.openConnection() == EXIT_SUCCESS );
+
+    pipelinedQueries( port );
+    pipelinedRegisterQueries( port );
+    unflushedQueries( port );
+    repeatedSweepsWithCache( port );
+    recallSetup( port );
+    rawWritesAndCache( port );
+    measurementTime( port );
+    traceData( port );
+
+    if( failures == 0 ) std::printf( "PASS\n" );
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,7 @@
+# Test programs of the GPIB layer. Each one prints PASS and exits with 0 when all
+# its checks pass.
+
+TEMPLATE = subdirs
+SUBDIRS = \
+    scpiCore \
+    simulatedK24xx